@@ -0,0 +1,166 @@
+#include "GeradorInstancias.h"
+#include <vector>
+#include <fstream>
+#include <random>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+// Ligação candidata entre dois nós da grade.
+struct LigacaoGerada {
+    int u, v;
+    int custo;
+    bool naArvore;
+    bool removida;
+    bool arco;
+    bool requerida;
+};
+
+// Union-find com compressão de caminhos, usado para sortear a árvore geradora.
+static int encontrarRaiz(vector<int>& pai, int x) {
+    while (pai[x] != x) {
+        pai[x] = pai[pai[x]];
+        x = pai[x];
+    }
+    return x;
+}
+
+// Gera a instância descrita pelos parâmetros e grava-a em `caminho`.
+void gerarInstancia(const ParametrosGerador& parametros, const string& nomeInstancia, const string& caminho) {
+    const int n = max(parametros.numNos, 2);
+    const int colunas = static_cast<int>(ceil(sqrt(static_cast<double>(n))));
+    const int linhas = (n + colunas - 1) / colunas;
+    const bool viario = parametros.tipo == ParametrosGerador::VIARIO;
+
+    mt19937 gerador(parametros.semente);
+    uniform_real_distribution<double> uniforme(0.0, 1.0);
+    uniform_int_distribution<int> custoGrade(1, 20);
+    uniform_int_distribution<int> demandaAleatoria(1, max(parametros.demandaMaxima, 1));
+
+    // Os nós são numerados de 1 a n em ordem de linha; a posição de um nó na grade é (id-1) / colunas, (id-1) % colunas.
+    auto id = [colunas](int linha, int coluna) { return linha * colunas + coluna + 1; };
+    vector<double> x(n + 1), y(n + 1);
+    for (int no = 1; no <= n; ++no) {
+        x[no] = (no - 1) % colunas;
+        y[no] = (no - 1) / colunas;
+        if (viario) {
+            x[no] += (uniforme(gerador) - 0.5) * 0.6;
+            y[no] += (uniforme(gerador) - 0.5) * 0.6;
+        }
+    }
+    auto custoLigacao = [&](int a, int b) {
+        if (!viario) return custoGrade(gerador);
+        return max(1, static_cast<int>(lround(10.0 * hypot(x[a] - x[b], y[a] - y[b]))));
+    };
+
+    // Ligações da grade: vizinho à direita, vizinho abaixo e, no modo viário, uma diagonal por célula sorteada.
+    // Como cada célula recebe no máximo uma diagonal, o grafo continua planar.
+    vector<LigacaoGerada> ligacoes;
+    ligacoes.reserve(static_cast<size_t>(n) * (viario ? 3 : 2));
+    auto ligar = [&](int a, int b) { ligacoes.push_back({a, b, custoLigacao(a, b), false, false, false, false}); };
+    for (int r = 0; r < linhas; ++r) {
+        for (int c = 0; c < colunas; ++c) {
+            int a = id(r, c);
+            if (a > n) continue;
+            if (c + 1 < colunas && id(r, c + 1) <= n) ligar(a, id(r, c + 1));
+            if (r + 1 < linhas && id(r + 1, c) <= n) ligar(a, id(r + 1, c));
+            if (viario && c + 1 < colunas && r + 1 < linhas && id(r + 1, c + 1) <= n && uniforme(gerador) < parametros.fracaoDiagonais) {
+                if (uniforme(gerador) < 0.5) ligar(a, id(r + 1, c + 1));
+                else ligar(id(r, c + 1), id(r + 1, c));
+            }
+        }
+    }
+
+    // Árvore geradora aleatória (Kruskal sobre uma ordem embaralhada): as suas ligações nunca são removidas
+    // nem passam a sentido único, garantindo a conexidade forte.
+    vector<size_t> ordem(ligacoes.size());
+    iota(ordem.begin(), ordem.end(), 0);
+    shuffle(ordem.begin(), ordem.end(), gerador);
+    vector<int> pai(n + 1);
+    iota(pai.begin(), pai.end(), 0);
+    for (size_t k : ordem) {
+        int ra = encontrarRaiz(pai, ligacoes[k].u), rb = encontrarRaiz(pai, ligacoes[k].v);
+        if (ra != rb) {
+            pai[ra] = rb;
+            ligacoes[k].naArvore = true;
+        }
+    }
+
+    int totalArestas = 0, totalArcos = 0, arestasRequeridas = 0, arcosRequeridos = 0;
+    for (LigacaoGerada& l : ligacoes) {
+        if (!l.naArvore) {
+            if (viario && uniforme(gerador) < parametros.fracaoRemocao) {
+                l.removida = true;
+                continue;
+            }
+            if (uniforme(gerador) < parametros.fracaoArcos) {
+                l.arco = true;
+                if (uniforme(gerador) < 0.5) swap(l.u, l.v);
+            }
+        }
+        l.requerida = uniforme(gerador) < (l.arco ? parametros.fracaoArcosRequeridos : parametros.fracaoArestasRequeridas);
+        if (l.arco) { totalArcos++; arcosRequeridos += l.requerida; }
+        else { totalArestas++; arestasRequeridas += l.requerida; }
+    }
+
+    vector<int> nosRequeridos;
+    for (int no = 1; no <= n; ++no) {
+        if (uniforme(gerador) < parametros.fracaoNosRequeridos) nosRequeridos.push_back(no);
+    }
+
+    int capacidade = parametros.capacidade > 0 ? parametros.capacidade : 20 * (parametros.demandaMaxima + 1) / 2;
+    int deposito = min(n, id(linhas / 2, colunas / 2));
+
+    ofstream arquivo(caminho);
+    if (!arquivo.is_open()) {
+        throw runtime_error("Falha ao criar o ficheiro da instancia: " + caminho);
+    }
+
+    arquivo << "Name:\t\t" << nomeInstancia << "\n"
+            << "Optimal value:\t-1\n"
+            << "#Vehicles:\t-1\n"
+            << "Capacity:\t" << capacidade << "\n"
+            << "Depot Node:\t" << deposito << "\n"
+            << "#Nodes:\t\t" << n << "\n"
+            << "#Edges:\t\t" << totalArestas << "\n"
+            << "#Arcs:\t\t" << totalArcos << "\n"
+            << "#Required N:\t" << nosRequeridos.size() << "\n"
+            << "#Required E:\t" << arestasRequeridas << "\n"
+            << "#Required A:\t" << arcosRequeridos << "\n\n";
+
+    arquivo << "ReN.\tDEMAND\tS. COST\n";
+    for (int no : nosRequeridos) {
+        int demanda = demandaAleatoria(gerador);
+        arquivo << "N" << no << "\t" << demanda << "\t" << demanda << "\n";
+    }
+
+    // As secções seguem a ordem dos ficheiros de dados/MCGRP: ReE., EDGE, ReA., ARC.
+    int contador = 0;
+    arquivo << "\nReE.\tFrom N.\tTo N.\tT. COST\tDEMAND\tS. COST\n";
+    for (const LigacaoGerada& l : ligacoes) {
+        if (l.removida || l.arco || !l.requerida) continue;
+        arquivo << "E" << ++contador << "\t" << l.u << "\t" << l.v << "\t" << l.custo << "\t" << demandaAleatoria(gerador) << "\t" << l.custo << "\n";
+    }
+    contador = 0;
+    arquivo << "\nEDGE\tFROM N.\tTO N.\tT. COST\n";
+    for (const LigacaoGerada& l : ligacoes) {
+        if (l.removida || l.arco || l.requerida) continue;
+        arquivo << "NrE" << ++contador << "\t" << l.u << "\t" << l.v << "\t" << l.custo << "\n";
+    }
+    contador = 0;
+    arquivo << "\nReA.\tFROM N.\tTO N.\tT. COST\tDEMAND\tS. COST\n";
+    for (const LigacaoGerada& l : ligacoes) {
+        if (l.removida || !l.arco || !l.requerida) continue;
+        arquivo << "A" << ++contador << "\t" << l.u << "\t" << l.v << "\t" << l.custo << "\t" << demandaAleatoria(gerador) << "\t" << l.custo << "\n";
+    }
+    contador = 0;
+    arquivo << "\nARC\tFROM N.\tTO N.\tT. COST\n";
+    for (const LigacaoGerada& l : ligacoes) {
+        if (l.removida || !l.arco || l.requerida) continue;
+        arquivo << "NrA" << ++contador << "\t" << l.u << "\t" << l.v << "\t" << l.custo << "\n";
+    }
+    arquivo.close();
+}
@@ -0,0 +1,30 @@
+#ifndef GERADOR_INSTANCIAS_H
+#define GERADOR_INSTANCIAS_H
+
+#include <string>
+
+using namespace std;
+
+// Parâmetros de uma instância sintética no formato .dat lido pelo construtor de Grafo.
+struct ParametrosGerador {
+    enum Tipo { GRADE, VIARIO } tipo = GRADE;
+    int numNos = 1000;
+    double fracaoNosRequeridos = 0.1;     // Fração dos nós com serviço.
+    double fracaoArestasRequeridas = 0.3; // Fração das ligações de dois sentidos com serviço.
+    double fracaoArcos = 0.2;             // Fração das ligações fora da árvore geradora que passam a ter sentido único.
+    double fracaoArcosRequeridos = 0.3;   // Fração dos arcos com serviço.
+    double fracaoRemocao = 0.2;           // (VIARIO) Fração das ligações da grade que não existem.
+    double fracaoDiagonais = 0.1;         // (VIARIO) Fração das células da grade com uma diagonal.
+    int demandaMaxima = 10;
+    int capacidade = 0;                   // 0 calcula uma capacidade para cerca de 20 serviços por rota.
+    unsigned int semente = 42;
+};
+
+// Gera a instância descrita pelos parâmetros e grava-a em `caminho`.
+// GRADE: grade retangular com custos aleatórios; VIARIO: grade perturbada e planar, com ligações removidas,
+// diagonais e custos proporcionais ao comprimento euclidiano. Em ambos os casos uma árvore geradora aleatória
+// mantém-se com dois sentidos, o que garante que o grafo é fortemente conexo.
+// Lança runtime_error se o ficheiro não puder ser criado.
+void gerarInstancia(const ParametrosGerador& parametros, const string& nomeInstancia, const string& caminho);
+
+#endif // GERADOR_INSTANCIAS_H
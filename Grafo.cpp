@@ -1,10 +1,18 @@
 #include "Grafo.h"
+#include "Memoria.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 #include <stdexcept>
+#include <unordered_map>
+#include <thread>
+#include <queue>
+#include <functional>
+#include <atomic>
+#include <numeric>
+#include <cstdlib>
 #include <x86intrin.h> // Para obter os ciclos de clock do processador e medir o tempo de execução.
 
 // Inclusões específicas do sistema operativo para a criação de diretórios.
@@ -16,8 +24,20 @@
 
 using namespace std;
 
-const int INF = 1e9; // Representação de um valor muito elevado para simular o infinito em custos.
 const int MAX_2OPT_PASSES = 2000; // Limite de iterações para a heurística 2-opt numa única rota, para evitar loops longos.
+const int VIZINHOS_2OPT = 8;           // Tamanho das listas de vizinhos do 2-opt sem restrições de tempo.
+const int MAX_MOVIMENTOS_VIZINHOS = 2000; // Limite de movimentos da busca por listas de vizinhos numa única rota.
+const int CADEIA_MAX_OROPT = 5;        // Maior cadeia de paragens deslocada de uma vez pelo or-opt.
+const int MIN_ROTAS_POR_THREAD_2OPT = 8; // Abaixo disto, uma thread adicional do 2-opt não compensa o seu arranque.
+const int MAX_PASSES_PERIODICO = 20; // Limite de passagens do refinamento da atribuição de dias no modo periódico.
+const uint16_t SEM_PREDECESSOR = numeric_limits<uint16_t>::max(); // Marca de `pred` para pares sem caminho.
+const int LIMIAR_DECOMPOSICAO = 10000; // A partir deste número de serviços, a instância é resolvida por grupos.
+const long long MAX_COMBINACOES_DIAS = 1024; // Combinações geradas por omissão para um serviço sem lista em FREQ.
+const double FRACAO_MEMORIA_FISICA = 0.5; // Sem limite de memória, parte da memória física dada às tabelas de distâncias.
+const long long ORCAMENTO_MEMORIA_SEM_PROC = 2LL * 1024 * 1024 * 1024; // O mesmo orçamento, se a memória física for desconhecida.
+const int MAX_SERVICOS_GRUPO = 4000;   // Limita a tabela reduzida de cada grupo a cerca de 64 MB.
+
+thread_local const TabelaDistanciasGrupo* Grafo::tabelaGrupo = nullptr;
 
 // Função auxiliar para remover espaços em branco, tabulações e quebras de linha do início e do fim de uma string.
 string limparEspacosGlobal(const string& s) {
@@ -26,12 +46,49 @@ string limparEspacosGlobal(const string& s) {
     return (inicio == string::npos || fim == string::npos) ? "" : s.substr(inicio, fim - inicio + 1);
 }
 
+// Lê os nomes base das instâncias a partir de um arquivo CSV de referência.
+vector<string> lerNomesBaseInstanciasDoCSV(const string& caminhoCSV) {
+    vector<string> nomes;
+    ifstream csvFile(caminhoCSV);
+    string linha;
+
+    if (!csvFile.is_open()) {
+        cerr << "ERRO: Nao foi possivel abrir '" << caminhoCSV << "' para ler nomes de instancias." << endl;
+        return nomes;
+    }
+
+    getline(csvFile, linha); // Ignora a linha de cabeçalho
+
+    while (getline(csvFile, linha)) {
+        stringstream ss(linha);
+        string nomeInstanciaBase;
+        getline(ss, nomeInstanciaBase, ',');
+        if (!nomeInstanciaBase.empty()) {
+            nomes.push_back(limparEspacosGlobal(nomeInstanciaBase));
+        }
+    }
+    csvFile.close();
+    if (nomes.empty()) {
+        cerr << "AVISO: Nenhum nome de instancia lido de '" << caminhoCSV << "'" << endl;
+    }
+    return nomes;
+}
+
 // O construtor é responsável pela leitura e interpretação do ficheiro da instância, inicializando o objeto Grafo.
-Grafo::Grafo(const string& nomeArquivo) {
+Grafo::Grafo(const string& nomeArquivo, long long limiteMemoriaBytes) {
     // Inicialização dos membros da classe para garantir um estado inicial consistente.
     this->numVertices = 0;
+    this->limiteMemoriaBytes = limiteMemoriaBytes;
+    this->representacao = REPR_DENSA;
+    this->distancias16 = true;
+    this->distanciasCalculadas = false;
+    this->caminhoHierarquia = nomeArquivo + ".ch";
     this->capacidadeVeiculo = 0;
     this->noDeposito = 0;
+    this->duracaoMaximaRota = 0;
+    this->possuiJanelasTempo = false;
+    this->numDias = 1;
+    this->formatoRotasExpandidas = ROTAS_EXPANDIDAS_NENHUMA;
     
     int contador_id_servico = 1; // Atribui um ID numérico sequencial a cada serviço para facilitar a referência interna.
     ifstream arquivo(nomeArquivo);
@@ -43,6 +100,7 @@ Grafo::Grafo(const string& nomeArquivo) {
     
     // A leitura do ficheiro inteiro para um buffer em memória otimiza o acesso, evitando múltiplas leituras de disco.
     vector<string> bufferLinhas;
+    unordered_map<string, int> indicePorIdOriginal; // Preenchido apenas quando a secção TW. está presente.
     while (getline(arquivo, linha)) {
         bufferLinhas.push_back(linha);
     }
@@ -60,23 +118,52 @@ Grafo::Grafo(const string& nomeArquivo) {
             sscanf(linhaProcessada.c_str(), "Capacity: %d", &capacidadeVeiculo);
         } else if (linhaProcessada.find("Depot Node:") != string::npos) {
             sscanf(linhaProcessada.c_str(), "Depot Node: %d", &noDeposito);
+        } else if (linhaProcessada.find("#Days:") != string::npos) {
+            sscanf(linhaProcessada.c_str(), "#Days: %d", &numDias);
+            if (numDias < 1 || numDias > 31) {
+                throw runtime_error("Numero de dias invalido (aceite de 1 a 31).");
+            }
+        } else if (linhaProcessada.find("Max Duration:") != string::npos) {
+            sscanf(linhaProcessada.c_str(), "Max Duration: %d", &duracaoMaximaRota);
         } else if (linhaProcessada.find("#Nodes:") != string::npos) {
             sscanf(linhaProcessada.c_str(), "#Nodes: %d", &numVertices);
-            // Com o número de vértices definido, alocamos dinamicamente as matrizes necessárias.
-            if (numVertices > 0) {
-                custosDiretos.assign(numVertices + 1, vector<int>(numVertices + 1, INF));
-                for(int i = 0; i <= numVertices; ++i) custosDiretos[i][i] = 0;
-                matrizAdj.assign(numVertices + 1, vector<int>(numVertices + 1, 0));
-            } else {
+            // As matrizes só são alocadas no fim da leitura, quando os custos permitem escolher a largura das células.
+            if (numVertices <= 0) {
                 cerr << "Erro: Número de vértices inválido (" << numVertices << ") no ficheiro " << nomeArquivo << endl;
                 throw runtime_error("Numero de vertices invalido.");
             }
+            verticesRequeridos.redimensionar(numVertices);
+        }
+        // As contagens do cabeçalho permitem reservar de uma só vez a lista de ligações e os conjuntos de requeridos.
+        else if (linhaProcessada.find("#Edges:") != string::npos || linhaProcessada.find("#Arcs:") != string::npos) {
+            int quantidade = 0;
+            if (sscanf(linhaProcessada.c_str(), "%*s %d", &quantidade) == 1 && quantidade > 0) {
+                ligacoes.reserve(ligacoes.capacity() + quantidade);
+            }
+        } else if (linhaProcessada.find("#Required E:") != string::npos) {
+            int quantidade = 0;
+            if (sscanf(linhaProcessada.c_str(), "#Required E: %d", &quantidade) == 1 && quantidade > 0) {
+                arestasRequeridasOriginal.reservar(quantidade);
+            }
+        } else if (linhaProcessada.find("#Required A:") != string::npos) {
+            int quantidade = 0;
+            if (sscanf(linhaProcessada.c_str(), "#Required A: %d", &quantidade) == 1 && quantidade > 0) {
+                arcosRequeridosOriginal.reservar(quantidade);
+            }
         }
         else if (linhaProcessada.find("ReN.") != string::npos) { secaoAtual = "ReN"; continue; }
         else if (linhaProcessada.find("ReE.") != string::npos) { secaoAtual = "ReE"; continue; }
         else if (linhaProcessada.find("ReA.") != string::npos) { secaoAtual = "ReA"; continue; }
         else if (linhaProcessada.find("EDGE") != string::npos) { secaoAtual = "EDGE"; continue; }
         else if (linhaProcessada.find("ARC") != string::npos) { secaoAtual = "ARC"; continue; }
+        else if (linhaProcessada.find("TW.") != string::npos || linhaProcessada.find("FREQ.") != string::npos) {
+            // Janelas de tempo e frequências referem-se a serviços já lidos, identificados pelo seu id original.
+            secaoAtual = linhaProcessada.find("TW.") != string::npos ? "TW" : "FREQ";
+            for (size_t i = 0; i < servicosRequeridos.size(); ++i) {
+                indicePorIdOriginal[servicosRequeridos[i].id_original] = i;
+            }
+            continue;
+        }
         else if (linhaProcessada.find("END") != string::npos) { break; }
 
         if (numVertices == 0 && (secaoAtual != "")) {
@@ -98,10 +185,10 @@ Grafo::Grafo(const string& nomeArquivo) {
                 s.demanda = demanda_val;
                 s.custo_percurso = 0;
                 s.custo_servico = custo_s_val;
+                s.tempo_servico = custo_s_val;
                 servicosRequeridos.push_back(s);
                 if(no_num > 0 && no_num <= numVertices) {
-                   verticesRequeridos.insert(no_num);
-                   matrizAdj[no_num][no_num] = 3;
+                   verticesRequeridos.inserir(no_num);
                 }
             }
         }
@@ -117,13 +204,11 @@ Grafo::Grafo(const string& nomeArquivo) {
                 s.demanda = demanda_val;
                 s.custo_percurso = custo_t_val;
                 s.custo_servico = custo_s_val;
+                s.tempo_servico = custo_t_val + custo_s_val;
                 servicosRequeridos.push_back(s);
                 if (u_val > 0 && u_val <= numVertices && v_val > 0 && v_val <= numVertices) {
-                    custosDiretos[u_val][v_val] = min(custosDiretos[u_val][v_val], custo_t_val);
-                    custosDiretos[v_val][u_val] = min(custosDiretos[v_val][u_val], custo_t_val);
-                    matrizAdj[u_val][v_val] = 2;
-                    matrizAdj[v_val][u_val] = 2;
-                    arestasRequeridasOriginal.insert({min(u_val, v_val), max(u_val,v_val)});
+                    ligacoes.push_back({u_val, v_val, custo_t_val, 2, true});
+                    arestasRequeridasOriginal.inserir(min(u_val, v_val), max(u_val, v_val));
                 }
             }
         }
@@ -139,11 +224,11 @@ Grafo::Grafo(const string& nomeArquivo) {
                 s.demanda = demanda_val;
                 s.custo_percurso = custo_t_val;
                 s.custo_servico = custo_s_val;
+                s.tempo_servico = custo_t_val + custo_s_val;
                 servicosRequeridos.push_back(s);
                 if (u_val > 0 && u_val <= numVertices && v_val > 0 && v_val <= numVertices) {
-                    custosDiretos[u_val][v_val] = min(custosDiretos[u_val][v_val], custo_t_val);
-                    matrizAdj[u_val][v_val] = 1;
-                    arcosRequeridosOriginal.insert({u_val,v_val});
+                    ligacoes.push_back({u_val, v_val, custo_t_val, 1, true});
+                    arcosRequeridosOriginal.inserir(u_val, v_val);
                 }
             }
         }
@@ -151,10 +236,7 @@ Grafo::Grafo(const string& nomeArquivo) {
             int no_de, no_para, custo_val;
             if (sscanf(linhaProcessada.c_str(), "NrE%*d %d %d %d", &no_de, &no_para, &custo_val) == 3) {
                 if (no_de > 0 && no_de <= numVertices && no_para > 0 && no_para <= numVertices) {
-                    custosDiretos[no_de][no_para] = min(custosDiretos[no_de][no_para], custo_val);
-                    custosDiretos[no_para][no_de] = min(custosDiretos[no_para][no_de], custo_val);
-                    if (matrizAdj[no_de][no_para] == 0) matrizAdj[no_de][no_para] = 2;
-                    if (matrizAdj[no_para][no_de] == 0) matrizAdj[no_para][no_de] = 2;
+                    ligacoes.push_back({no_de, no_para, custo_val, 2, false});
                 }
             }
         }
@@ -162,115 +244,628 @@ Grafo::Grafo(const string& nomeArquivo) {
             int no_de, no_para, custo_val;
             if (sscanf(linhaProcessada.c_str(), "NrA%*d %d %d %d", &no_de, &no_para, &custo_val) == 3) {
                 if (no_de > 0 && no_de <= numVertices && no_para > 0 && no_para <= numVertices) {
-                    custosDiretos[no_de][no_para] = min(custosDiretos[no_de][no_para], custo_val);
-                    if (matrizAdj[no_de][no_para] == 0) matrizAdj[no_de][no_para] = 1;
+                    ligacoes.push_back({no_de, no_para, custo_val, 1, false});
+                }
+            }
+        }
+        else if (secaoAtual == "TW") { // Janelas de tempo: id, início, fim e, opcionalmente, a duração do atendimento.
+            char id_str[20];
+            int inicio_val, fim_val, duracao_val;
+            int lidos = sscanf(linhaProcessada.c_str(), "%s %d %d %d", id_str, &inicio_val, &fim_val, &duracao_val);
+            if (lidos >= 3) {
+                auto it = indicePorIdOriginal.find(id_str);
+                if (it == indicePorIdOriginal.end()) {
+                    cerr << "AVISO: Janela de tempo para servico desconhecido '" << id_str << "' ignorada." << endl;
+                    continue;
+                }
+                Servico& s = servicosRequeridos[it->second];
+                s.inicio_janela = inicio_val;
+                s.fim_janela = fim_val;
+                if (lidos == 4) s.tempo_servico = duracao_val;
+                possuiJanelasTempo = true;
+            }
+        }
+        else if (secaoAtual == "FREQ") { // Frequências: id, frequência e, opcionalmente, as combinações de dias permitidas (ex.: 1,3,5).
+            stringstream ss(linhaProcessada);
+            string id_str;
+            int frequencia_val;
+            if (ss >> id_str >> frequencia_val) {
+                auto it = indicePorIdOriginal.find(id_str);
+                if (it == indicePorIdOriginal.end()) {
+                    cerr << "AVISO: Frequencia para servico desconhecido '" << id_str << "' ignorada." << endl;
+                    continue;
+                }
+                Servico& s = servicosRequeridos[it->second];
+                s.frequencia = frequencia_val;
+                string combinacao;
+                while (ss >> combinacao) {
+                    unsigned int mascara = 0;
+                    stringstream ssDias(combinacao);
+                    string dia;
+                    while (getline(ssDias, dia, ',')) {
+                        int d = atoi(dia.c_str());
+                        if (d >= 1 && d <= 31) mascara |= 1u << (d - 1);
+                    }
+                    s.combinacoes_dias.push_back(mascara);
                 }
             }
         }
     }
+
+    // Validação das frequências e preenchimento das combinações por omissão (todas as escolhas de `frequencia` dias).
+    for (Servico& s : servicosRequeridos) {
+        if (s.frequencia < 1 || s.frequencia > numDias) {
+            throw runtime_error("Frequencia do servico " + s.id_original + " fora do horizonte de planeamento.");
+        }
+        unsigned int diasValidos = (1u << numDias) - 1;
+        vector<unsigned int> combinacoes;
+        for (unsigned int mascara : s.combinacoes_dias) {
+            if ((mascara & ~diasValidos) == 0 && __builtin_popcount(mascara) == s.frequencia) {
+                combinacoes.push_back(mascara);
+            } else {
+                cerr << "AVISO: Combinacao de dias invalida ignorada para o servico " << s.id_original << "." << endl;
+            }
+        }
+        if (combinacoes.empty()) {
+            // C(numDias, frequencia) cresce depressa (C(31, 15) passa de 3·10⁸): acima do teto, a instância tem de
+            // listar as combinações permitidas em vez de as deixar geradas por omissão.
+            long long totalCombinacoes = 1;
+            for (int k = 1; k <= s.frequencia && totalCombinacoes <= MAX_COMBINACOES_DIAS; ++k) {
+                totalCombinacoes = totalCombinacoes * (numDias - s.frequencia + k) / k;
+            }
+            if (totalCombinacoes > MAX_COMBINACOES_DIAS) {
+                throw runtime_error("Servico " + s.id_original + " com frequencia " + to_string(s.frequencia) + " em " +
+                                    to_string(numDias) + " dias admite mais de " + to_string(MAX_COMBINACOES_DIAS) +
+                                    " combinacoes; indique as combinacoes permitidas na seccao FREQ.");
+            }
+            // Enumera as máscaras com exatamente `frequencia` bits ligados (truque de Gosper).
+            unsigned int mascara = (1u << s.frequencia) - 1;
+            while (mascara <= diasValidos) {
+                combinacoes.push_back(mascara);
+                unsigned int c = mascara & -mascara;
+                unsigned int r = mascara + c;
+                if (r == 0) break;
+                mascara = (((r ^ mascara) >> 2) / c) | r;
+            }
+        }
+        s.combinacoes_dias.swap(combinacoes);
+    }
+
+    escolherRepresentacao();
 }
 
-// Implementação da heurística 2-opt para otimização local das rotas.
-void Grafo::aplicar2Opt(vector<Rota>& todasAsRotas) {
-    // Itera sobre cada rota para tentar otimizá-la individualmente.
-    for (auto& rota : todasAsRotas) {
-        // A troca só é aplicável em rotas com pelo menos duas arestas de deslocamento não adjacentes.
-        if (rota.paradas.size() < 4) {
-            continue;
+// Um caminho mínimo simples usa cada ligação no máximo uma vez e tem no máximo n-1 ligações, pelo que o menor
+// destes dois limites majora todas as distâncias finitas. Se couber abaixo do infinito de 16 bits, as distâncias
+// ocupam metade do espaço. A representação é então a mais completa que cabe no limite de memória.
+void Grafo::escolherRepresentacao() {
+    long long somaCustos = 0;
+    int maiorCusto = 0;
+    for (const Ligacao& l : ligacoes) {
+        if (l.custo < 0) {
+            throw runtime_error("Custo negativo na ligacao " + to_string(l.u) + "-" + to_string(l.v) + " nao suportado.");
         }
+        somaCustos += l.custo;
+        maiorCusto = max(maiorCusto, l.custo);
+    }
+    long long maiorDistancia = min(somaCustos, static_cast<long long>(numVertices - 1) * maiorCusto);
+    distancias16 = maiorDistancia < DistanciaSaturada<uint16_t>::infinito();
+
+    // Sem limite explícito, o orçamento é uma fração da memória física. Os predecessores são guardados em 16 bits,
+    // pelo que a matriz de predecessores só existe abaixo de SEM_PREDECESSOR vértices.
+    long long orcamento = limiteMemoriaBytes;
+    if (orcamento <= 0) {
+        const long long fisica = memoriaFisicaBytes();
+        orcamento = fisica > 0 ? static_cast<long long>(fisica * FRACAO_MEMORIA_FISICA) : ORCAMENTO_MEMORIA_SEM_PROC;
+    }
+    const long long celulas = static_cast<long long>(numVertices + 1) * (numVertices + 1);
+    const long long bytesAdj = celulas * sizeof(uint8_t);
+    const long long bytesDist = celulas * (distancias16 ? sizeof(uint16_t) : sizeof(uint32_t));
+    const long long bytesPred = celulas * sizeof(uint16_t);
+    const bool predRepresentavel = numVertices < SEM_PREDECESSOR;
+    if (predRepresentavel && bytesAdj + bytesDist + bytesPred <= orcamento) representacao = REPR_DENSA;
+    else if (bytesAdj + bytesDist <= orcamento) representacao = REPR_DENSA_SEM_PRED;
+    else {
+        // A tabela entre extremos tem uma linha e uma coluna por extremo distinto (depósito incluído).
+        vector<char> ehExtremo(numVertices + 1, 0);
+        long long numExtremos = 0;
+        auto contarExtremo = [&](int v) {
+            if (v >= 0 && v <= numVertices && !ehExtremo[v]) {
+                ehExtremo[v] = 1;
+                numExtremos++;
+            }
+        };
+        contarExtremo(noDeposito);
+        for (const Servico& s : servicosRequeridos) {
+            contarExtremo(s.u);
+            contarExtremo(s.v);
+        }
+        const long long bytesTabela = numExtremos * numExtremos * (distancias16 ? sizeof(uint16_t) : sizeof(uint32_t));
+        representacao = bytesTabela <= orcamento ? REPR_EXTREMOS : REPR_HIERARQUIA;
+    }
+    if (!matrizesDensas()) return;
+
+    // Mesmas regras da leitura original: nós requeridos com código 3, ligações requeridas sobrepõem-se ao código
+    // existente e as não requeridas só preenchem posições vazias.
+    matrizAdj.redimensionar(numVertices + 1, numVertices + 1, 0);
+    verticesRequeridos.paraCada([this](int v) { matrizAdj(v, v) = 3; });
+    for (const Ligacao& l : ligacoes) {
+        if (l.requerida || matrizAdj(l.u, l.v) == 0) matrizAdj(l.u, l.v) = l.codigo;
+        if (l.codigo == 2 && (l.requerida || matrizAdj(l.v, l.u) == 0)) matrizAdj(l.v, l.u) = l.codigo;
+    }
+}
 
-        bool melhoriaEncontradaNesteCiclo = true;
-        int pass_count = 0;
-        
-        // Continua a aplicar o 2-opt na mesma rota até que não haja mais melhorias (convergência local).
-        while (melhoriaEncontradaNesteCiclo && pass_count < MAX_2OPT_PASSES) {
-            melhoriaEncontradaNesteCiclo = false;
-            pass_count++;
-            
-            long long melhorDeltaParaRota = 0; // Armazena a maior redução de custo encontrada nesta passagem.
-            size_t melhor_i = -1, melhor_j = -1; // Armazena os índices da melhor troca.
-
-            // Seleciona a primeira aresta de deslocamento (entre a paragem i e i+1).
-            for (size_t i = 0; i < rota.paradas.size() - 2; ++i) {
-                // Seleciona a segunda aresta (entre j e j+1), garantindo que não seja adjacente à primeira.
-                for (size_t j = i + 2; j < rota.paradas.size() - 1; ++j) {
-                    
-                    ParadaRota& p_i = rota.paradas[i];
-                    ParadaRota& p_i_mais_1 = rota.paradas[i+1];
-                    ParadaRota& p_j = rota.paradas[j];
-                    ParadaRota& p_j_mais_1 = rota.paradas[j+1];
-
-                    // Custo do percurso atual: (i -> i+1) + (j -> j+1)
-                    long long custo_atual_segmento = 0;
-                    if (dist[p_i.v][p_i_mais_1.u] == INF || dist[p_j.v][p_j_mais_1.u] == INF) {
-                         custo_atual_segmento = INF;
-                    } else {
-                        custo_atual_segmento = (long long)dist[p_i.v][p_i_mais_1.u] + dist[p_j.v][p_j_mais_1.u];
-                    }
-                    
-                    // Custo do percurso após a troca: (i -> j) + (i+1 -> j+1)
-                    long long custo_novo_segmento = 0;
-                    if (dist[p_i.v][p_j.u] == INF || dist[p_i_mais_1.v][p_j_mais_1.u] == INF) {
-                        custo_novo_segmento = INF;
-                    } else {
-                        custo_novo_segmento = (long long)dist[p_i.v][p_j.u] + dist[p_i_mais_1.v][p_j_mais_1.u];
-                    }
+// Representação escolhida para a instância.
+RepresentacaoGrafo Grafo::representacaoEscolhida() const {
+    return representacao;
+}
 
-                    if (custo_atual_segmento == INF || custo_novo_segmento == INF) continue;
+// Nome da representação, usado nos relatórios.
+string Grafo::nomeRepresentacao() const {
+    switch (representacao) {
+        case REPR_DENSA: return "densa";
+        case REPR_DENSA_SEM_PRED: return "densa_sem_pred";
+        case REPR_EXTREMOS: return "extremos";
+        default: return "hierarquia";
+    }
+}
 
-                    // Calcula a diferença de custo. Um valor negativo indica uma melhoria.
-                    long long delta = custo_novo_segmento - custo_atual_segmento;
+// Indica se a instância impõe limites de duração ou janelas de tempo.
+bool Grafo::restricoesTempoAtivas() const {
+    return duracaoMaximaRota > 0 || possuiJanelasTempo;
+}
 
-                    // Adota a estratégia "best improvement": armazena a melhor troca encontrada.
-                    if (delta < melhorDeltaParaRota) {
-                        melhorDeltaParaRota = delta;
-                        melhor_i = i;
-                        melhor_j = j;
-                    }
+// Constrói o segmento unitário de uma paragem: o depósito não tem duração e está aberto durante todo o turno.
+SegmentoRota Grafo::segmentoDaParada(const ParadaRota& parada) const {
+    SegmentoRota seg;
+    seg.noInicio = parada.u;
+    seg.noFim = parada.v;
+    if (parada.idx_servico < 0) {
+        seg.inicioMaisTarde = duracaoMaximaRota > 0 ? duracaoMaximaRota : INF;
+        return seg;
+    }
+    const Servico& s = servicosRequeridos[parada.idx_servico];
+    seg.custo = static_cast<long long>(s.custo_percurso) + s.custo_servico;
+    seg.demanda = s.demanda;
+    seg.duracao = s.tempo_servico;
+    seg.inicioMaisCedo = s.inicio_janela;
+    seg.inicioMaisTarde = s.fim_janela;
+    return seg;
+}
+
+// Concatenação de dois segmentos (Vidal et al., 2013). O deslocamento entre eles é o caminho mínimo,
+// e o tempo é medido nas mesmas unidades do custo.
+SegmentoRota Grafo::concatenarSegmentos(const SegmentoRota& a, const SegmentoRota& b) const {
+    long long deslocamento = distancia(a.noFim, b.noInicio);
+    long long delta = a.duracao - a.atraso + deslocamento;
+    long long espera = max(b.inicioMaisCedo - delta - a.inicioMaisTarde, 0LL);
+    long long atrasoNovo = max(a.inicioMaisCedo + delta - b.inicioMaisTarde, 0LL);
+
+    SegmentoRota seg;
+    seg.noInicio = a.noInicio;
+    seg.noFim = b.noFim;
+    seg.custo = a.custo + deslocamento + b.custo;
+    seg.demanda = a.demanda + b.demanda;
+    seg.duracao = a.duracao + b.duracao + deslocamento + espera;
+    seg.atraso = a.atraso + b.atraso + atrasoNovo;
+    seg.inicioMaisCedo = max(b.inicioMaisCedo - delta, a.inicioMaisCedo) - espera;
+    seg.inicioMaisTarde = min(b.inicioMaisTarde - delta, a.inicioMaisTarde) + atrasoNovo;
+    return seg;
+}
+
+// A penalidade é nula numa rota que respeita todas as janelas e o limite de turno.
+long long Grafo::penalidadeTempo(const SegmentoRota& rotaCompleta) const {
+    long long excesso = duracaoMaximaRota > 0 ? max(rotaCompleta.duracao - duracaoMaximaRota, 0LL) : 0;
+    return rotaCompleta.atraso + excesso;
+}
+
+// Percorre a rota uma única vez para preencher os seus atributos de tempo.
+void Grafo::avaliarTempoRota(Rota& rota) const {
+    if (rota.paradas.empty()) return;
+    SegmentoRota seg = segmentoDaParada(rota.paradas[0]);
+    for (size_t k = 1; k < rota.paradas.size(); ++k) {
+        seg = concatenarSegmentos(seg, segmentoDaParada(rota.paradas[k]));
+    }
+    rota.duracao = static_cast<int>(min(seg.duracao, static_cast<long long>(INF)));
+    rota.atraso_tempo = static_cast<int>(min(penalidadeTempo(seg), static_cast<long long>(INF)));
+}
+
+// Preenche os segmentos unitários, os prefixos e os sufixos de uma rota, reutilizando os vetores recebidos.
+void Grafo::calcularSegmentos(const Rota& rota, vector<SegmentoRota>& unitario, vector<SegmentoRota>& prefixo, vector<SegmentoRota>& sufixo) const {
+    const size_t m = rota.paradas.size();
+    unitario.resize(m);
+    prefixo.resize(m);
+    sufixo.resize(m);
+    if (m == 0) return;
+    for (size_t k = 0; k < m; ++k) unitario[k] = segmentoDaParada(rota.paradas[k]);
+    prefixo[0] = unitario[0];
+    for (size_t k = 1; k < m; ++k) prefixo[k] = concatenarSegmentos(prefixo[k-1], unitario[k]);
+    sufixo[m-1] = unitario[m-1];
+    for (size_t k = m - 1; k-- > 0; ) sufixo[k] = concatenarSegmentos(unitario[k], sufixo[k+1]);
+}
+
+// Define o limite de duração de cada rota; 0 remove o limite.
+void Grafo::definirDuracaoMaximaRota(int duracao) {
+    duracaoMaximaRota = max(duracao, 0);
+}
+
+// Define a janela de tempo e a duração do atendimento de um serviço.
+void Grafo::definirJanelaTempo(int idxServico, int inicio, int fim, int duracaoAtendimento) {
+    if (idxServico < 0 || idxServico >= static_cast<int>(servicosRequeridos.size())) {
+        throw out_of_range("Indice de servico invalido para janela de tempo.");
+    }
+    Servico& s = servicosRequeridos[idxServico];
+    s.inicio_janela = inicio;
+    s.fim_janela = fim;
+    s.tempo_servico = duracaoAtendimento;
+    possuiJanelasTempo = true;
+}
+
+// Número de serviços requeridos lidos da instância.
+int Grafo::numeroServicos() const {
+    return servicosRequeridos.size();
+}
+
+// Duração do atendimento de um serviço.
+int Grafo::tempoServico(int idxServico) const {
+    if (idxServico < 0 || idxServico >= static_cast<int>(servicosRequeridos.size())) {
+        throw out_of_range("Indice de servico invalido.");
+    }
+    return servicosRequeridos[idxServico].tempo_servico;
+}
+
+// Índice do serviço com o id original indicado, ou -1 se não existir.
+int Grafo::indiceServico(const string& idOriginal) const {
+    for (size_t i = 0; i < servicosRequeridos.size(); ++i) {
+        if (servicosRequeridos[i].id_original == idOriginal) return i;
+    }
+    return -1;
+}
+
+// Demanda atual de um serviço.
+int Grafo::demandaServico(int idxServico) const {
+    if (idxServico < 0 || idxServico >= static_cast<int>(servicosRequeridos.size())) {
+        throw out_of_range("Indice de servico invalido.");
+    }
+    return servicosRequeridos[idxServico].demanda;
+}
+
+// Altera a demanda de um serviço. Uma demanda acima da capacidade não caberia em nenhuma rota.
+void Grafo::definirDemanda(int idxServico, int demanda) {
+    if (idxServico < 0 || idxServico >= static_cast<int>(servicosRequeridos.size())) {
+        throw out_of_range("Indice de servico invalido para alteracao de demanda.");
+    }
+    if (demanda < 0 || demanda > capacidadeVeiculo) {
+        throw invalid_argument("Demanda " + to_string(demanda) + " fora do intervalo [0, " + to_string(capacidadeVeiculo) + "].");
+    }
+    servicosRequeridos[idxServico].demanda = demanda;
+}
+
+// Soma das capacidades reservadas pelas estruturas principais; não inclui cópias temporárias do solver.
+long long Grafo::memoriaEstimadaBytes() const {
+    long long total = matrizAdj.bytes() + dist16.bytes() + dist32.bytes() + pred.bytes();
+    total += verticesRequeridos.bytes() + arestasRequeridasOriginal.bytes() + arcosRequeridosOriginal.bytes();
+    total += ligacoes.capacity() * sizeof(Ligacao) + indiceExtremo.capacity() * sizeof(int) + hierarquia.bytes();
+    for (const Servico& s : servicosRequeridos) {
+        total += sizeof(Servico) + s.id_original.capacity() + s.combinacoes_dias.capacity() * sizeof(unsigned int);
+    }
+    return total;
+}
+
+// As rotas são independentes nesta vizinhança, pelo que são distribuídas dinamicamente por um conjunto de threads.
+// Poucas rotas não compensam o arranque das threads e são otimizadas na thread atual.
+void Grafo::aplicar2Opt(vector<Rota>& todasAsRotas, chrono::steady_clock::time_point prazo, int numThreads) const {
+    const bool comTempo = restricoesTempoAtivas();
+    if (numThreads <= 0) numThreads = max(1u, thread::hardware_concurrency());
+    numThreads = min(numThreads, static_cast<int>(todasAsRotas.size() / MIN_ROTAS_POR_THREAD_2OPT));
+
+    auto otimizar = [this, &todasAsRotas, prazo, comTempo](atomic<size_t>& proxima) {
+        vector<SegmentoRota> unitario, prefixo, sufixo;
+        for (size_t r = proxima++; r < todasAsRotas.size(); r = proxima++) {
+            bool dentroDoPrazo = comTempo ? aplicar2OptMelhorMovimento(todasAsRotas[r], unitario, prefixo, sufixo, prazo)
+                                          : aplicar2OptVizinhos(todasAsRotas[r], prazo);
+            if (!dentroDoPrazo) return;
+        }
+    };
+    atomic<size_t> proxima(0);
+    if (numThreads <= 1) {
+        otimizar(proxima);
+        return;
+    }
+    vector<thread> trabalhadores;
+    for (int t = 0; t < numThreads; ++t) trabalhadores.emplace_back(otimizar, ref(proxima));
+    for (thread& t : trabalhadores) t.join();
+}
+
+// Implementação da heurística 2-opt para otimização local de uma rota com restrições de tempo.
+// Cada movimento é avaliado em O(1) concatenando o prefixo, o segmento invertido e o sufixo da rota,
+// o que contabiliza corretamente os custos assimétricos dentro do segmento invertido e as restrições de tempo.
+bool Grafo::aplicar2OptMelhorMovimento(Rota& rota, vector<SegmentoRota>& unitario, vector<SegmentoRota>& prefixo, vector<SegmentoRota>& sufixo,
+                                       chrono::steady_clock::time_point prazo) const {
+    const bool comPrazo = prazo != chrono::steady_clock::time_point::max();
+
+    // A troca só é aplicável em rotas com pelo menos duas arestas de deslocamento não adjacentes.
+    if (rota.paradas.size() < 4) {
+        return true;
+    }
+
+    const size_t m = rota.paradas.size();
+
+    bool melhoriaEncontradaNesteCiclo = true;
+    int pass_count = 0;
+
+    // Continua a aplicar o 2-opt na mesma rota até que não haja mais melhorias (convergência local).
+    while (melhoriaEncontradaNesteCiclo && pass_count < MAX_2OPT_PASSES) {
+        if (comPrazo && chrono::steady_clock::now() >= prazo) return false;
+        melhoriaEncontradaNesteCiclo = false;
+        pass_count++;
+
+        // Pré-cálculo dos segmentos unitários, dos prefixos e dos sufixos da rota atual.
+        calcularSegmentos(rota, unitario, prefixo, sufixo);
+
+        const SegmentoRota& rotaAtual = prefixo[m-1];
+        if (rotaAtual.custo >= INF) break; // Rotas com ligações inalcançáveis não são otimizadas.
+
+        long long melhorDeltaParaRota = 0; // Armazena a maior redução de custo encontrada nesta passagem.
+        long long melhorPenalidade = penalidadeTempo(rotaAtual);
+        size_t melhor_i = -1, melhor_j = -1; // Armazena os índices da melhor troca.
+
+        // Seleciona a primeira aresta de deslocamento (entre a paragem i e i+1).
+        for (size_t i = 0; i < m - 2; ++i) {
+            // O segmento invertido (j, j-1, ..., i+1) cresce uma paragem de cada vez.
+            SegmentoRota invertido = unitario[i+1];
+            // Seleciona a segunda aresta (entre j e j+1), garantindo que não seja adjacente à primeira.
+            for (size_t j = i + 2; j < m - 1; ++j) {
+                invertido = concatenarSegmentos(unitario[j], invertido);
+                SegmentoRota novaRota = concatenarSegmentos(concatenarSegmentos(prefixo[i], invertido), sufixo[j+1]);
+                if (novaRota.custo >= INF) continue;
+
+                // Calcula a diferença de custo. Um valor negativo indica uma melhoria.
+                long long delta = novaRota.custo - rotaAtual.custo;
+                long long penalidade = penalidadeTempo(novaRota);
+
+                // Adota a estratégia "best improvement": reduzir a penalidade de tempo tem prioridade sobre o custo.
+                if (penalidade < melhorPenalidade || (penalidade == melhorPenalidade && delta < melhorDeltaParaRota)) {
+                    melhorPenalidade = penalidade;
+                    melhorDeltaParaRota = delta;
+                    melhor_i = i;
+                    melhor_j = j;
                 }
             }
+        }
+
+        // Se uma melhoria foi encontrada, aplica a troca correspondente.
+        if (melhor_i != static_cast<size_t>(-1)) {
+            // A troca é efetuada ao inverter o segmento da rota entre os pontos de corte.
+            reverse(rota.paradas.begin() + melhor_i + 1, rota.paradas.begin() + melhor_j + 1);
+            // Atualiza o custo total da rota com a economia obtida.
+            rota.custo_total += melhorDeltaParaRota;
+            melhoriaEncontradaNesteCiclo = true; // Sinaliza para verificar novamente a rota em busca de mais melhorias.
+        }
+    }
+    return true;
+}
+
+// Melhoria intra-rota sem restrições de tempo, onde só o custo conta. Com x_p a paragem na posição p:
+//  - 2-opt: inverter x_{i+1}..x_j cria as ligações x_i -> x_j e x_{i+1} -> x_{j+1} e percorre o segmento ao contrário.
+//    Com as somas acumuladas dos deslocamentos no sentido atual (F) e no sentido inverso (B), o delta custa O(1):
+//    d(x_i, x_j) + d(x_{i+1}, x_{j+1}) + (B[j] - B[i+1]) - (F[j+1] - F[i]);
+//  - or-opt: retirar uma cadeia de 1 a CADEIA_MAX_OROPT paragens e reinseri-la noutra posição, pela mesma ordem ou
+//    invertida (cada serviço mantém o seu sentido), também com delta O(1) a partir de F e B.
+// Cada paragem a procura movimentos que criem a ligação a -> b para uma das VIZINHOS_2OPT paragens b com início
+// mais próximo do seu fim, aplicando o primeiro que melhore; as paragens sem movimento ficam marcadas ("don't look")
+// até um movimento tocar numa das suas ligações. Quando não resta nenhuma paragem ativa, uma passagem completa pelos
+// 2-opt e pelas realocações de uma paragem confirma o ótimo local (ou reativa a busca); as cadeias mais longas só são
+// procuradas a partir das listas de vizinhos. A rota só é substituída se ficar mais barata do que a recebida.
+bool Grafo::aplicar2OptVizinhos(Rota& rota, chrono::steady_clock::time_point prazo) const {
+    const bool comPrazo = prazo != chrono::steady_clock::time_point::max();
+    const int m = rota.paradas.size();
+    if (m < 4) return true;
+
+    // As paragens são identificadas pela posição inicial; ordem[p] é a paragem na posição p e posicao[] o inverso.
+    // As paragens no depósito (posições 0 e m-1) nunca mudam de posição.
+    const vector<ParadaRota> paradas = rota.paradas;
+    vector<int> ordem(m), posicao(m);
+    for (int p = 0; p < m; ++p) ordem[p] = posicao[p] = p;
+    auto deslocamento = [&](int a, int b) -> long long { return distancia(paradas[a].v, paradas[b].u); };
+    auto ligacao = [&](int p, int q) { return deslocamento(ordem[p], ordem[q]); };
+
+    vector<long long> F(m, 0), B(m, 0);
+    auto recalcularSomas = [&](int desde) {
+        for (int p = max(desde, 0); p + 1 < m; ++p) {
+            F[p + 1] = F[p] + ligacao(p, p + 1);
+            B[p + 1] = B[p] + ligacao(p + 1, p);
+        }
+    };
+    recalcularSomas(0);
+    if (F[m - 1] >= INF) return true; // Rotas com ligações inalcançáveis não são otimizadas.
+    const long long custoInicial = F[m - 1];
+
+    // Listas de vizinhos: para cada paragem, as de início mais próximo do seu fim (exceto o depósito inicial).
+    const int k = min(VIZINHOS_2OPT, m - 2);
+    vector<int> vizinhos(static_cast<size_t>(m) * k);
+    vector<pair<long long, int>> candidatas;
+    for (int a = 0; a < m - 1; ++a) {
+        candidatas.clear();
+        for (int b = 1; b < m; ++b) if (b != a) candidatas.push_back(make_pair(deslocamento(a, b), b));
+        partial_sort(candidatas.begin(), candidatas.begin() + k, candidatas.end());
+        for (int t = 0; t < k; ++t) vizinhos[static_cast<size_t>(a) * k + t] = candidatas[t].second;
+    }
+
+    // Deltas dos movimentos (0 quando algum deslocamento novo é inalcançável, para que nunca sejam aplicados).
+    auto delta2Opt = [&](int i, int j) -> long long {
+        long long primeira = ligacao(i, j), segunda = ligacao(i + 1, j + 1), interior = B[j] - B[i + 1];
+        if (primeira >= INF || segunda >= INF || interior >= INF) return 0;
+        return primeira + segunda + interior - (F[j + 1] - F[i]);
+    };
+    // Retira a cadeia das posições p..p+t-1 e insere-a entre as posições q e q+1, fora da cadeia e da ligação que
+    // a antecede; invertida, a cadeia é percorrida de p+t-1 para p.
+    auto cadeiaValida = [&](int p, int t, int q) {
+        return p >= 1 && p + t <= m - 1 && q >= 0 && q <= m - 2 && (q < p - 1 || q >= p + t);
+    };
+    auto deltaOrOpt = [&](int p, int t, int q, bool invertida) -> long long {
+        const int u = p + t - 1;
+        long long fecho = ligacao(p - 1, u + 1);
+        long long entrada = invertida ? ligacao(q, u) : ligacao(q, p);
+        long long saida = invertida ? ligacao(p, q + 1) : ligacao(u, q + 1);
+        long long interior = invertida ? (B[u] - B[p]) - (F[u] - F[p]) : 0;
+        if (fecho >= INF || entrada >= INF || saida >= INF || (invertida && B[u] - B[p] >= INF)) return 0;
+        return fecho + entrada + saida + interior - ligacao(p - 1, p) - ligacao(u, u + 1) - ligacao(q, q + 1);
+    };
+
+    vector<char> ativa(m, 0);
+    vector<int> fila;
+    size_t frente = 0;
+    auto ativar = [&](int parada) {
+        if (parada != m - 1 && !ativa[parada]) {
+            ativa[parada] = 1;
+            fila.push_back(parada);
+        }
+    };
+    int movimentos = 0;
+    auto registar = [&](int desde, int ate) {
+        for (int p = desde; p <= ate; ++p) posicao[ordem[p]] = p;
+        recalcularSomas(desde - 1);
+        movimentos++;
+    };
+    auto aplicar2Opt = [&](int i, int j) {
+        int tocadas[4] = { ordem[i], ordem[i + 1], ordem[j], ordem[j + 1] };
+        reverse(ordem.begin() + i + 1, ordem.begin() + j + 1);
+        registar(i + 1, j);
+        for (int parada : tocadas) ativar(parada);
+    };
+    auto aplicarOrOpt = [&](int p, int t, int q, bool invertida) {
+        const int u = p + t - 1;
+        int tocadas[6] = { ordem[p - 1], ordem[p], ordem[u], ordem[u + 1], ordem[q], ordem[q + 1] };
+        int desde, ate;
+        if (q > u) {
+            rotate(ordem.begin() + p, ordem.begin() + u + 1, ordem.begin() + q + 1);
+            desde = p;
+            ate = q;
+            if (invertida) reverse(ordem.begin() + q - t + 1, ordem.begin() + q + 1);
+        } else {
+            rotate(ordem.begin() + q + 1, ordem.begin() + p, ordem.begin() + u + 1);
+            desde = q + 1;
+            ate = u;
+            if (invertida) reverse(ordem.begin() + q + 1, ordem.begin() + q + 1 + t);
+        }
+        registar(desde, ate);
+        for (int parada : tocadas) ativar(parada);
+    };
+    auto tentarOrOpt = [&](int p, int t, int q, bool invertida) -> bool {
+        if (!cadeiaValida(p, t, q) || deltaOrOpt(p, t, q, invertida) >= 0) return false;
+        aplicarOrOpt(p, t, q, invertida);
+        return true;
+    };
+
+    // Primeiro movimento que melhore e crie a ligação a -> b, para algum vizinho b de a.
+    auto melhorarParada = [&](int a) -> bool {
+        for (int v = 0; v < k; ++v) {
+            int pa = posicao[a], pb = posicao[vizinhos[static_cast<size_t>(a) * k + v]];
+            if (pb == pa + 1) continue;
+            if (pb >= pa + 2) {
+                // a no papel de x_i (nova ligação x_i -> x_j) ou de x_{i+1} (nova ligação x_{i+1} -> x_{j+1}).
+                if (pb <= m - 2 && delta2Opt(pa, pb) < 0) { aplicar2Opt(pa, pb); return true; }
+                if (pa >= 1 && delta2Opt(pa - 1, pb - 1) < 0) { aplicar2Opt(pa - 1, pb - 1); return true; }
+            }
+            for (int t = 1; t <= CADEIA_MAX_OROPT; ++t) {
+                // A cadeia que começa em b passa para logo a seguir a a, ou a que acaba em a para logo antes de b;
+                // invertidas, a cadeia que acaba em b passa para a seguir a a, ou a que começa em a para antes de b.
+                if (tentarOrOpt(pb, t, pa, false) || tentarOrOpt(pa - t + 1, t, pb - 1, false)) return true;
+                if (t > 1 && (tentarOrOpt(pb - t + 1, t, pa, true) || tentarOrOpt(pa, t, pb - 1, true))) return true;
+            }
+        }
+        return false;
+    };
+
+    bool dentroDoPrazo = true;
+    for (int a = 0; a < m - 1; ++a) ativar(a);
+    while (dentroDoPrazo && movimentos < MAX_MOVIMENTOS_VIZINHOS) {
+        while (frente < fila.size() && movimentos < MAX_MOVIMENTOS_VIZINHOS) {
+            if (comPrazo && (frente & 63) == 0 && chrono::steady_clock::now() >= prazo) {
+                dentroDoPrazo = false;
+                break;
+            }
+            int a = fila[frente++];
+            ativa[a] = 0;
+            if (melhorarParada(a)) ativar(a);
+            if (frente > static_cast<size_t>(m) * 4) {
+                fila.erase(fila.begin(), fila.begin() + frente);
+                frente = 0;
+            }
+        }
+        if (!dentroDoPrazo || movimentos >= MAX_MOVIMENTOS_VIZINHOS) break;
+        if (comPrazo && chrono::steady_clock::now() >= prazo) {
+            dentroDoPrazo = false;
+            break;
+        }
 
-            // Se uma melhoria foi encontrada, aplica a troca correspondente.
-            if (melhor_i != static_cast<size_t>(-1)) {
-                // A troca é efetuada ao inverter o segmento da rota entre os pontos de corte.
-                reverse(rota.paradas.begin() + melhor_i + 1, rota.paradas.begin() + melhor_j + 1);
-                // Atualiza o custo total da rota com a economia obtida.
-                rota.custo_total += melhorDeltaParaRota;
-                melhoriaEncontradaNesteCiclo = true; // Sinaliza para verificar novamente a rota em busca de mais melhorias.
+        // Passagem completa de confirmação: o primeiro movimento que melhore reativa as paragens que tocou.
+        bool encontrou = false;
+        for (int i = 0; i < m - 2 && !encontrou; ++i) {
+            for (int j = i + 2; j < m - 1 && !encontrou; ++j) {
+                if (delta2Opt(i, j) < 0) { aplicar2Opt(i, j); encontrou = true; }
             }
         }
+        for (int p = 1; p < m - 1 && !encontrou; ++p) {
+            for (int q = 0; q < m - 1 && !encontrou; ++q) encontrou = tentarOrOpt(p, 1, q, false);
+        }
+        if (!encontrou) break;
+    }
+
+    if (F[m - 1] < custoInicial) {
+        for (int p = 0; p < m; ++p) rota.paradas[p] = paradas[ordem[p]];
+        rota.custo_total += F[m - 1] - custoInicial;
     }
+    return dentroDoPrazo;
 }
 
-// Procura o serviço não atendido mais próximo que seja viável em termos de capacidade.
-int Grafo::encontrarServicoMaisProximo(int localizacaoAtual, int capacidadeAtual) {
-    int melhorServicoIdx = -1;
+// Procura, entre os serviços do subconjunto ainda não atendidos, o mais próximo que seja viável em termos de capacidade e, se pedido, de tempo.
+int Grafo::encontrarServicoMaisProximo(const vector<int>& indices, const vector<char>& atendido, int localizacaoAtual, int capacidadeAtual,
+                                       const SegmentoRota& prefixo, bool respeitarTempo) const {
+    int melhorPosicao = -1;
     int menorCustoParaServico = INF;
-
-    // Itera sobre todos os serviços para avaliar cada um como candidato.
-    for (size_t i = 0; i < servicosRequeridos.size(); ++i) {
+    SegmentoRota deposito = segmentoDaParada({'D', "0", noDeposito, noDeposito, -1});
+    // Com a hierarquia, uma única pesquisa a partir da localização atual dá a distância a todos os candidatos
+    // (dentro de um grupo da decomposição, a tabela reduzida já tem essas distâncias).
+    const bool usarBaldes = representacao == REPR_HIERARQUIA && tabelaGrupo == nullptr;
+    vector<int> distanciasAlvos;
+    if (usarBaldes) hierarquia.distanciasParaAlvos(localizacaoAtual, distanciasAlvos);
+
+    // Itera sobre todos os serviços do subconjunto para avaliar cada um como candidato.
+    for (size_t p = 0; p < indices.size(); ++p) {
         // O serviço só é um candidato se ainda não tiver sido atendido.
-        if (!servicosRequeridos[i].atendido) {
-            int noInicioServico = servicosRequeridos[i].u;
+        if (!atendido[p]) {
+            const Servico& s = servicosRequeridos[indices[p]];
+            int noInicioServico = s.u;
 
             if (localizacaoAtual < 0 || localizacaoAtual > numVertices || noInicioServico < 0 || noInicioServico > numVertices) {
                 continue;
             }
-            int custoParaAlcancar = dist[localizacaoAtual][noInicioServico];
+            int custoParaAlcancar = INF;
+            if (!usarBaldes) custoParaAlcancar = distancia(localizacaoAtual, noInicioServico);
+            else {
+                int alvo = hierarquia.indiceAlvo(noInicioServico);
+                if (alvo >= 0 && distanciasAlvos[alvo] < HierarquiaContracao::INF_HIERARQUIA) custoParaAlcancar = distanciasAlvos[alvo];
+            }
 
             // Critérios de viabilidade: o serviço deve ser alcançável e a sua demanda não pode exceder a capacidade restante.
-            if (custoParaAlcancar != INF && servicosRequeridos[i].demanda <= capacidadeAtual) {
+            if (custoParaAlcancar != INF && s.demanda <= capacidadeAtual) {
                 // Critérios de seleção: menor custo de deslocamento. Em caso de empate, o ID sequencial menor é usado como desempate.
-                if (melhorServicoIdx == -1 ||
+                if (melhorPosicao == -1 ||
                     custoParaAlcancar < menorCustoParaServico ||
-                    (custoParaAlcancar == menorCustoParaServico && servicosRequeridos[i].id_numerico_sequencial < servicosRequeridos[melhorServicoIdx].id_numerico_sequencial)) {
+                    (custoParaAlcancar == menorCustoParaServico && s.id_numerico_sequencial < servicosRequeridos[indices[melhorPosicao]].id_numerico_sequencial)) {
+                    // O teste de tempo só é feito para candidatos que melhorariam a escolha: prefixo + serviço + regresso ao depósito.
+                    if (respeitarTempo) {
+                        SegmentoRota comServico = concatenarSegmentos(prefixo, segmentoDaParada({'S', "", s.u, s.v, indices[p]}));
+                        if (penalidadeTempo(concatenarSegmentos(comServico, deposito)) > 0) continue;
+                    }
                     menorCustoParaServico = custoParaAlcancar;
-                    melhorServicoIdx = i;
+                    melhorPosicao = p;
                 }
             }
         }
     }
-    return melhorServicoIdx; // Retorna o índice do melhor candidato encontrado.
+    return melhorPosicao; // Retorna a posição (em indices) do melhor candidato encontrado.
 }
 
 // Lê o valor de referência de ciclos de clock a partir de um ficheiro CSV externo.
@@ -320,9 +915,9 @@ void Grafo::salvarEstatisticas() {
     resultados << "Numero total de vertices," << numVertices << endl;
     resultados << "Numero total de arestas," << contarArestas() << endl;
     resultados << "Numero total de arcos," << contarArcos() << endl;
-    resultados << "Numero de vertices requeridos," << verticesRequeridos.size() << endl;
-    resultados << "Numero de arestas requeridas," << arestasRequeridasOriginal.size() << endl;
-    resultados << "Numero de arcos requeridos," << arcosRequeridosOriginal.size() << endl;
+    resultados << "Numero de vertices requeridos," << verticesRequeridos.tamanho() << endl;
+    resultados << "Numero de arestas requeridas," << arestasRequeridasOriginal.tamanho() << endl;
+    resultados << "Numero de arcos requeridos," << arcosRequeridosOriginal.tamanho() << endl;
     resultados << "Densidade do grafo," << fixed << setprecision(4) << calcularDensidade() << endl;
     resultados << "Componentes conexos," << contarComponentesConexos() << endl;
     resultados << "Grau minimo," << calcularGrauMinimo() << endl;
@@ -331,12 +926,37 @@ void Grafo::salvarEstatisticas() {
     resultados.close();
 }
 
+// Reconstrói os códigos de matrizAdj a partir das ligações, aplicando as mesmas regras e a mesma ordem da leitura.
+// A chave de cada par ordenado (i, j) é i * (numVertices + 1) + j.
+unordered_map<long long, char> Grafo::codigosAdjacencia() const {
+    unordered_map<long long, char> codigos;
+    codigos.reserve(2 * ligacoes.size() + verticesRequeridos.tamanho());
+    const long long base = numVertices + 1;
+    verticesRequeridos.paraCada([&codigos, base](int v) { codigos[v * base + v] = 3; });
+    for (const Ligacao& l : ligacoes) {
+        char& ida = codigos[l.u * base + l.v];
+        if (l.requerida || ida == 0) ida = l.codigo;
+        if (l.codigo == 2) {
+            char& volta = codigos[l.v * base + l.u];
+            if (l.requerida || volta == 0) volta = l.codigo;
+        }
+    }
+    return codigos;
+}
+
 // Conta o número de arestas (não direcionadas) no grafo.
 int Grafo::contarArestas() {
     int total = 0;
+    if (!matrizesDensas()) {
+        const long long base = numVertices + 1;
+        for (const auto& par : codigosAdjacencia()) {
+            if (par.second == 2 && par.first / base < par.first % base) total++;
+        }
+        return total;
+    }
     for (int i = 1; i <= numVertices; ++i) {
         for (int j = i + 1; j <= numVertices; ++j) {
-            if (matrizAdj[i][j] == 2) total++;
+            if (matrizAdj(i, j) == 2) total++;
         }
     }
     return total;
@@ -345,9 +965,15 @@ int Grafo::contarArestas() {
 // Conta o número de arcos (direcionados) no grafo.
 int Grafo::contarArcos() {
     int total = 0;
+    if (!matrizesDensas()) {
+        for (const auto& par : codigosAdjacencia()) {
+            if (par.second == 1) total++;
+        }
+        return total;
+    }
     for (int i = 1; i <= numVertices; ++i) {
         for (int j = 1; j <= numVertices; ++j) {
-            if (matrizAdj[i][j] == 1) total++;
+            if (matrizAdj(i, j) == 1) total++;
         }
     }
     return total;
@@ -365,7 +991,7 @@ double Grafo::calcularDensidade() {
 void Grafo::dfs(int v, vector<bool>& visitado) {
     visitado[v] = true;
     for (int i = 1; i <= numVertices; ++i) {
-        if (!visitado[i] && (matrizAdj[v][i] > 0 || matrizAdj[i][v] > 0)) {
+        if (!visitado[i] && (matrizAdj(v, i) > 0 || matrizAdj(i, v) > 0)) {
             dfs(i, visitado);
         }
     }
@@ -373,6 +999,24 @@ void Grafo::dfs(int v, vector<bool>& visitado) {
 
 // Usa a DFS para determinar o número de componentes conexos do grafo.
 int Grafo::contarComponentesConexos() {
+    // Sem matriz de adjacência, as componentes são obtidas com union-find sobre a lista de ligações.
+    if (!matrizesDensas()) {
+        vector<int> pai(numVertices + 1);
+        for (int i = 0; i <= numVertices; ++i) pai[i] = i;
+        auto raiz = [&pai](int x) {
+            while (pai[x] != x) x = pai[x] = pai[pai[x]];
+            return x;
+        };
+        int componentes = numVertices;
+        for (const Ligacao& l : ligacoes) {
+            int a = raiz(l.u), b = raiz(l.v);
+            if (a != b) {
+                pai[a] = b;
+                componentes--;
+            }
+        }
+        return componentes;
+    }
     vector<bool> visitado(numVertices + 1, false);
     int componentes = 0;
     for (int i = 1; i <= numVertices; ++i) {
@@ -385,49 +1029,217 @@ int Grafo::contarComponentesConexos() {
 }
 
 // Implementação do algoritmo de Floyd-Warshall para pré-calcular os caminhos mínimos entre todos os pares de vértices.
+// Sem memória para as matrizes densas, recorre a Dijkstra apenas a partir dos extremos dos serviços.
 void Grafo::calcularCaminhosMinimosComCustos() {
     if (numVertices == 0) return;
-    dist.assign(numVertices + 1, vector<int>(numVertices + 1, INF));
-    pred.assign(numVertices + 1, vector<int>(numVertices + 1, -1));
+    if (representacao == REPR_HIERARQUIA) {
+        prepararHierarquia();
+    } else if (representacao == REPR_EXTREMOS) {
+        calcularDistanciasEntreExtremos();
+    } else {
+        const bool comPred = (representacao == REPR_DENSA);
+        if (distancias16) floydWarshall(dist16, comPred);
+        else floydWarshall(dist32, comPred);
+    }
+    distanciasCalculadas = true;
+}
+
+template <class T>
+void Grafo::floydWarshall(MatrizPlana<T, MEM_DIST>& dist, bool comPred) {
+    typedef DistanciaSaturada<T> Saturada;
+    typedef typename Saturada::Soma Soma;
+    dist.redimensionar(numVertices + 1, numVertices + 1, Saturada::infinito());
+    if (comPred) pred.redimensionar(numVertices + 1, numVertices + 1, SEM_PREDECESSOR);
 
-    // Fase de inicialização: preenche as matrizes com os custos das ligações diretas.
+    // Fase de inicialização: preenche as matrizes com os custos das ligações diretas (o menor, em ligações paralelas).
     for (int i = 0; i <= numVertices; ++i) {
-        for (int j = 0; j <= numVertices; ++j) {
-            if (i == j) {
-                dist[i][j] = 0;
-                pred[i][j] = i;
-            } else if (i > 0 && j > 0 && i <= numVertices && j <= numVertices && custosDiretos[i][j] != INF) {
-                dist[i][j] = custosDiretos[i][j];
-                pred[i][j] = i;
+        dist(i, i) = 0;
+        if (comPred) pred(i, i) = i;
+    }
+    for (const Ligacao& l : ligacoes) {
+        if (l.u == l.v) continue;
+        if (static_cast<T>(l.custo) < dist(l.u, l.v)) dist(l.u, l.v) = l.custo;
+        if (l.codigo == 2 && static_cast<T>(l.custo) < dist(l.v, l.u)) dist(l.v, l.u) = l.custo;
+    }
+    if (comPred) {
+        for (int i = 1; i <= numVertices; ++i) {
+            for (int j = 1; j <= numVertices; ++j) {
+                if (i != j && dist(i, j) != Saturada::infinito()) pred(i, j) = i;
             }
         }
     }
 
-    // Loop principal do Floyd-Warshall, que relaxa as arestas iterativamente.
+    // Loop principal do Floyd-Warshall, que relaxa as arestas iterativamente. A soma é feita num tipo mais largo:
+    // se dist(i, k) ou dist(k, j) for infinito, a soma nunca fica abaixo de dist(i, j) e não há atualização.
     for (int k = 0; k <= numVertices; ++k) { // Vértice intermediário `k`
+        const T* linhaK = dist.linha(k);
+        const uint16_t* predK = comPred ? pred.linha(k) : nullptr;
         for (int i = 0; i <= numVertices; ++i) { // Vértice de origem `i`
-            for (int j = 0; j <= numVertices; ++j) { // Vértice de destino `j`
-                // Verifica se o caminho de `i` para `j` via `k` é mais curto que o caminho conhecido.
-                if (dist[i][k] != INF && dist[k][j] != INF &&
-                    (static_cast<long long>(dist[i][k]) + dist[k][j] < dist[i][j])) {
-                    // Se for mais curto, atualiza a distância e o predecessor.
-                    dist[i][j] = dist[i][k] + dist[k][j];
-                    pred[i][j] = pred[k][j];
+            T* linhaI = dist.linha(i);
+            const Soma distIK = linhaI[k];
+            if (distIK == Saturada::infinito()) continue;
+            if (comPred) {
+                uint16_t* predI = pred.linha(i);
+                for (int j = 0; j <= numVertices; ++j) { // Vértice de destino `j`
+                    Soma candidato = distIK + linhaK[j];
+                    if (candidato < linhaI[j]) {
+                        linhaI[j] = static_cast<T>(candidato);
+                        predI[j] = predK[j];
+                    }
+                }
+            } else {
+                // Sem predecessores, o ciclo interno é um mínimo elemento a elemento, que o compilador vetoriza.
+                for (int j = 0; j <= numVertices; ++j) {
+                    Soma candidato = distIK + linhaK[j];
+                    linhaI[j] = candidato < linhaI[j] ? static_cast<T>(candidato) : linhaI[j];
+                }
+            }
+        }
+    }
+}
+
+// Lista de adjacência compacta (CSR) construída a partir das ligações lidas.
+void Grafo::listaAdjacencia(vector<int>& inicio, vector<int>& destino, vector<int>& custo, bool invertida) const {
+    inicio.assign(numVertices + 2, 0);
+    for (const Ligacao& l : ligacoes) {
+        inicio[(invertida ? l.v : l.u) + 1]++;
+        if (l.codigo == 2) inicio[(invertida ? l.u : l.v) + 1]++;
+    }
+    for (int v = 0; v <= numVertices; ++v) inicio[v + 1] += inicio[v];
+    destino.resize(inicio[numVertices + 1]);
+    custo.resize(inicio[numVertices + 1]);
+    vector<int> proximo(inicio.begin(), inicio.end() - 1);
+    for (const Ligacao& l : ligacoes) {
+        int de = invertida ? l.v : l.u, para = invertida ? l.u : l.v;
+        destino[proximo[de]] = para;
+        custo[proximo[de]++] = l.custo;
+        if (l.codigo == 2) {
+            destino[proximo[para]] = de;
+            custo[proximo[para]++] = l.custo;
+        }
+    }
+}
+
+// Dijkstra a partir de cada extremo (depósito e extremos dos serviços), guardando apenas as distâncias entre extremos.
+// A tabela resultante tem E x E entradas, com E o número de extremos distintos, em vez de (n+1) x (n+1).
+void Grafo::calcularDistanciasEntreExtremos() {
+    indiceExtremo.assign(numVertices + 1, -1);
+    vector<int> extremos;
+    auto registarExtremo = [&](int v) {
+        if (v >= 0 && v <= numVertices && indiceExtremo[v] == -1) {
+            indiceExtremo[v] = extremos.size();
+            extremos.push_back(v);
+        }
+    };
+    registarExtremo(noDeposito);
+    for (const Servico& s : servicosRequeridos) {
+        registarExtremo(s.u);
+        registarExtremo(s.v);
+    }
+
+    const long long numExtremos = extremos.size();
+    long long bytesTabela = numExtremos * numExtremos * static_cast<long long>(distancias16 ? sizeof(uint16_t) : sizeof(uint32_t));
+    if (limiteMemoriaBytes > 0 && bytesTabela > limiteMemoriaBytes) {
+        throw runtime_error("Limite de memoria insuficiente: a tabela de distancias entre " + to_string(numExtremos) +
+                            " extremos exige " + to_string(bytesTabela / (1024 * 1024)) + " MB.");
+    }
+    if (distancias16) dist16.redimensionar(numExtremos, numExtremos, DistanciaSaturada<uint16_t>::infinito());
+    else dist32.redimensionar(numExtremos, numExtremos, DistanciaSaturada<uint32_t>::infinito());
+    pred.libertar();
+
+    vector<int> inicio, destino, custo;
+    listaAdjacencia(inicio, destino, custo);
+
+    vector<int> distanciaOrigem(numVertices + 1, INF);
+    vector<int> visitados;
+    typedef pair<int, int> EntradaFila; // (distância, vértice)
+    for (int origem = 0; origem < numExtremos; ++origem) {
+        priority_queue<EntradaFila, vector<EntradaFila>, greater<EntradaFila>> fila;
+        distanciaOrigem[extremos[origem]] = 0;
+        visitados.push_back(extremos[origem]);
+        fila.push({0, extremos[origem]});
+        while (!fila.empty()) {
+            EntradaFila atual = fila.top();
+            fila.pop();
+            int v = atual.second;
+            if (atual.first > distanciaOrigem[v]) continue;
+            for (int a = inicio[v]; a < inicio[v + 1]; ++a) {
+                int w = destino[a];
+                int candidato = atual.first + custo[a];
+                if (candidato < distanciaOrigem[w]) {
+                    if (distanciaOrigem[w] == INF) visitados.push_back(w);
+                    distanciaOrigem[w] = candidato;
+                    fila.push({candidato, w});
                 }
             }
         }
+        for (int destinoIdx = 0; destinoIdx < numExtremos; ++destinoIdx) {
+            int d = distanciaOrigem[extremos[destinoIdx]];
+            if (d == INF) continue; // A célula já contém o infinito da largura escolhida.
+            if (distancias16) dist16(origem, destinoIdx) = d;
+            else dist32(origem, destinoIdx) = d;
+        }
+        // Repõe apenas os vértices alcançados, evitando reinicializar o vetor inteiro a cada origem.
+        for (int v : visitados) distanciaOrigem[v] = INF;
+        visitados.clear();
+    }
+}
+
+uint64_t Grafo::assinaturaRede() const {
+    uint64_t assinatura = 14695981039346656037ull;
+    auto misturar = [&assinatura](long long valor) {
+        for (int b = 0; b < 8; ++b) {
+            assinatura ^= static_cast<uint64_t>(valor >> (8 * b)) & 0xFF;
+            assinatura *= 1099511628211ull;
+        }
+    };
+    misturar(numVertices);
+    for (const Ligacao& l : ligacoes) {
+        misturar(l.u);
+        misturar(l.v);
+        misturar(l.custo);
+        misturar(l.codigo);
+    }
+    return assinatura;
+}
+
+// A hierarquia depende apenas da rede (não dos serviços nem das demandas), pelo que é construída uma vez e
+// reutilizada por todas as execuções sobre a mesma rede. Os extremos dos serviços ficam preparados como alvos
+// do modo muitos-para-muitos usado pelo Vizinho Mais Próximo.
+void Grafo::prepararHierarquia() {
+    const uint64_t assinatura = assinaturaRede();
+    if (!hierarquia.carregar(caminhoHierarquia, assinatura, numVertices)) {
+        vector<ArcoEntrada> arcos;
+        arcos.reserve(2 * ligacoes.size());
+        for (const Ligacao& l : ligacoes) {
+            arcos.push_back({l.u, l.v, l.custo});
+            if (l.codigo == 2) arcos.push_back({l.v, l.u, l.custo});
+        }
+        hierarquia.construir(numVertices, arcos);
+        if (!hierarquia.salvar(caminhoHierarquia, assinatura)) {
+            cerr << "Aviso: nao foi possivel gravar a hierarquia em " << caminhoHierarquia << "; sera reconstruida na proxima execucao." << endl;
+        }
     }
+    vector<int> alvos;
+    alvos.reserve(servicosRequeridos.size());
+    for (const Servico& s : servicosRequeridos) alvos.push_back(s.u);
+    hierarquia.prepararAlvos(alvos);
 }
 
 // Calcula o comprimento médio do caminho entre todos os pares de nós alcançáveis.
 void Grafo::calcularCaminhoMedio() {
     ofstream resultados("output/resultados.csv", ios::app);
+    if (!matrizesDensas()) {
+        resultados << "Caminho medio,Indisponivel na representacao " << nomeRepresentacao() << endl;
+        return;
+    }
     long long soma = 0;
     int contagem = 0;
     for (int i = 1; i <= numVertices; ++i) {
         for (int j = 1; j <= numVertices; ++j) {
-            if (i != j && dist[i][j] != INF) {
-                soma += dist[i][j];
+            int d = distancia(i, j);
+            if (i != j && d != INF) {
+                soma += d;
                 contagem++;
             }
         }
@@ -444,11 +1256,16 @@ void Grafo::calcularCaminhoMedio() {
 // Calcula o diâmetro do grafo, que corresponde ao maior dos caminhos mínimos.
 void Grafo::calcularDiametro() {
     ofstream resultados("output/resultados.csv", ios::app);
+    if (!matrizesDensas()) {
+        resultados << "Diametro do grafo,Indisponivel na representacao " << nomeRepresentacao() << endl;
+        return;
+    }
     int diametro = 0;
     for (int i = 1; i <= numVertices; ++i) {
         for (int j = 1; j <= numVertices; ++j) {
-            if (i != j && dist[i][j] != INF) {
-                diametro = max(diametro, dist[i][j]);
+            int d = distancia(i, j);
+            if (i != j && d != INF) {
+                diametro = max(diametro, d);
             }
         }
     }
@@ -459,16 +1276,21 @@ void Grafo::calcularDiametro() {
 // Calcula a métrica de centralidade de intermediação (betweenness centrality) para cada vértice.
 void Grafo::calcularIntermediacao() {
     ofstream resultados("output/resultados.csv", ios::app);
+    if (representacao != REPR_DENSA) {
+        resultados << "Intermediacao dos vertices,Indisponivel na representacao " << nomeRepresentacao() << endl;
+        return;
+    }
     vector<double> intermediacao(numVertices + 1, 0.0);
     
     for (int s = 1; s <= numVertices; ++s) {
         for (int t = 1; t <= numVertices; ++t) {
-            if (s != t && dist[s][t] != INF) {
+            if (s != t && distancia(s, t) != INF) {
                 vector<int> caminho_reverso;
                 int curr = t;
                 while (curr != s && curr != -1) {
                     caminho_reverso.push_back(curr);
-                    curr = pred[s][curr];
+                    uint16_t anterior = pred(s, curr);
+                    curr = anterior == SEM_PREDECESSOR ? -1 : anterior;
                 }
                 if (curr == s) {
                     for (size_t i = 0; i < caminho_reverso.size() -1 ; ++i) {
@@ -495,76 +1317,55 @@ void Grafo::calcularIntermediacao() {
     resultados.close();
 }
 
-// Calcula o grau mínimo entre todos os vértices do grafo.
-int Grafo::calcularGrauMinimo() {
-    int min_grau = INF;
-    if (numVertices == 0) return 0;
+// Grau de cada vértice: número de vértices j (incluindo o próprio) ligados a ele em algum sentido.
+vector<int> Grafo::calcularGraus() {
+    vector<int> graus(numVertices + 1, 0);
+    if (!matrizesDensas()) {
+        // Cada par não ordenado com código em algum sentido conta uma vez para cada extremo.
+        const long long base = numVertices + 1;
+        unordered_map<long long, char> codigos = codigosAdjacencia();
+        for (const auto& par : codigos) {
+            if (par.second == 0) continue;
+            long long i = par.first / base, j = par.first % base;
+            if (i == j) { graus[i]++; continue; }
+            auto inverso = codigos.find(j * base + i);
+            bool inversoAtivo = inverso != codigos.end() && inverso->second != 0;
+            if (inversoAtivo && i > j) continue; // O par já foi contado a partir de (j, i).
+            graus[i]++;
+            graus[j]++;
+        }
+        return graus;
+    }
     for(int i = 1; i <= numVertices; i++) {
-        int grau = 0;
         for(int j = 1; j <= numVertices; j++) {
-            if(matrizAdj[i][j] != 0 || matrizAdj[j][i] != 0) grau++;
+            if(matrizAdj(i, j) != 0 || matrizAdj(j, i) != 0) graus[i]++;
         }
-        if (grau < min_grau) min_grau = grau;
     }
-    return min_grau;
+    return graus;
+}
+
+// Calcula o grau mínimo entre todos os vértices do grafo.
+int Grafo::calcularGrauMinimo() {
+    if (numVertices == 0) return 0;
+    vector<int> graus = calcularGraus();
+    return *min_element(graus.begin() + 1, graus.end());
 }
 
 // Calcula o grau máximo entre todos os vértices do grafo.
 int Grafo::calcularGrauMaximo() {
-    int max_grau = 0;
     if (numVertices == 0) return 0;
-    for(int i = 1; i <= numVertices; i++) {
-        int grau = 0;
-        for(int j = 1; j <= numVertices; j++) {
-            if(matrizAdj[i][j] != 0 || matrizAdj[j][i] != 0) grau++;
-        }
-        if (grau > max_grau) max_grau = grau;
-    }
-    return max_grau;
+    vector<int> graus = calcularGraus();
+    return *max_element(graus.begin() + 1, graus.end());
 }
 
-// Método principal que coordena a construção da solução, a sua otimização e o armazenamento do resultado.
-void Grafo::construirESalvarSolucaoVM(const string& nomeInstancia, const string& pastaDeSaida) {
-    // Verificações de pré-condições para a execução.
-    if (numVertices == 0 || (noDeposito == 0 && numVertices > 0) ) {
-        cerr << "AVISO: Dados insuficientes para construir solucao para " << nomeInstancia << ". Abortando." << endl;
-        return;
-    }
-    // Caso trivial: se não há serviços, a solução tem custo zero e nenhuma rota.
-    if (servicosRequeridos.empty()) {
-        string nomeArquivoSaida = pastaDeSaida + "/sol-" + nomeInstancia + ".dat";
-        ofstream arquivoSaida(nomeArquivoSaida);
-        if (arquivoSaida.is_open()) {
-            unsigned long long inicio_total_algoritmo_ciclos_vazio = __rdtsc();
-            unsigned long long fim_vazio_ciclos = __rdtsc();
-            arquivoSaida << "0" << endl;
-            arquivoSaida << "0" << endl;
-            arquivoSaida << (fim_vazio_ciclos - inicio_total_algoritmo_ciclos_vazio) << endl;
-            arquivoSaida << lerClockRefDoCSV(nomeInstancia, 4) << endl;
-            arquivoSaida.close();
-        }
-        return;
-    }
-
-    if (capacidadeVeiculo <= 0) {
-        cerr << "AVISO: Capacidade do veiculo invalida (" << capacidadeVeiculo << ") para " << nomeInstancia << ". Abortando." << endl;
-        return;
-    }
-
-    // --- Início do processo de construção da solução ---
-    unsigned long long inicio_total_algoritmo_ciclos = __rdtsc();
-
-    // Passo 1: Pré-cálculo dos caminhos mínimos, fundamental para a heurística construtiva.
-    calcularCaminhosMinimosComCustos();
-
+// Constrói rotas com a heurística do Vizinho Mais Próximo para um subconjunto de serviços.
+// O estado de atendimento é local, pelo que várias construções podem correr em paralelo sobre o mesmo grafo.
+vector<Rota> Grafo::construirRotas(const vector<int>& indices) const {
     vector<Rota> todasAsRotas;
+    vector<char> atendido(indices.size(), 0);
     int servicosAtendidos = 0;
-    int totalServicos = servicosRequeridos.size();
-
-    // Reinicia o estado de todos os serviços para "não atendido".
-    for(auto& s : servicosRequeridos) {
-        s.atendido = false;
-    }
+    int totalServicos = indices.size();
+    bool comTempo = restricoesTempoAtivas();
 
     int contadorIdRota = 1;
 
@@ -576,25 +1377,32 @@ void Grafo::construirESalvarSolucaoVM(const string& nomeInstancia, const string&
         int cargaAtual = capacidadeVeiculo;
         int localizacaoAtual = noDeposito;
         // Todas as rotas iniciam-se no depósito.
-        rotaAtual.paradas.push_back({'D', "0", noDeposito, noDeposito});
+        rotaAtual.paradas.push_back({'D', "0", noDeposito, noDeposito, -1});
+        SegmentoRota prefixo = segmentoDaParada(rotaAtual.paradas.back());
 
         bool servicoAdicionadoNestaRota = false;
 
         // Loop interno: constrói uma rota individual, adicionando serviços sequencialmente.
         while (true) {
             // Passo 2: Aplicação da heurística construtiva do Vizinho Mais Próximo.
-            int proximoServicoIdx = encontrarServicoMaisProximo(localizacaoAtual, cargaAtual);
+            int proximaPosicao = encontrarServicoMaisProximo(indices, atendido, localizacaoAtual, cargaAtual, prefixo, comTempo);
+
+            // Um serviço que não cabe no tempo nem numa rota vazia é atendido isoladamente, com penalidade.
+            if (proximaPosicao == -1 && comTempo && !servicoAdicionadoNestaRota) {
+                proximaPosicao = encontrarServicoMaisProximo(indices, atendido, localizacaoAtual, cargaAtual, prefixo, false);
+            }
 
             // Se não for encontrado um serviço viável, a rota atual é finalizada.
-            if (proximoServicoIdx == -1) {
+            if (proximaPosicao == -1) {
                 break;
             }
 
-            Servico& servico = servicosRequeridos[proximoServicoIdx];
+            int proximoServicoIdx = indices[proximaPosicao];
+            const Servico& servico = servicosRequeridos[proximoServicoIdx];
             
             int custoParaAlcancarInicioServico = INF;
             if (localizacaoAtual >= 0 && localizacaoAtual <= numVertices && servico.u >= 0 && servico.u <= numVertices){
-                custoParaAlcancarInicioServico = dist[localizacaoAtual][servico.u];
+                custoParaAlcancarInicioServico = distancia(localizacaoAtual, servico.u);
             }
             
             if (custoParaAlcancarInicioServico == INF) {
@@ -608,13 +1416,14 @@ void Grafo::construirESalvarSolucaoVM(const string& nomeInstancia, const string&
             rotaAtual.demanda_total += servico.demanda;
             cargaAtual -= servico.demanda;
             
-            servico.atendido = true;
+            atendido[proximaPosicao] = 1;
             servicosAtendidos++;
             localizacaoAtual = servico.v; // A localização atual do veículo passa a ser o fim do serviço.
             servicoAdicionadoNestaRota = true;
             
             // Adiciona a paragem de serviço à sequência da rota.
-            rotaAtual.paradas.push_back({'S', to_string(servico.id_numerico_sequencial), servico.u, servico.v});
+            rotaAtual.paradas.push_back({'S', to_string(servico.id_numerico_sequencial), servico.u, servico.v, proximoServicoIdx});
+            if (comTempo) prefixo = concatenarSegmentos(prefixo, segmentoDaParada(rotaAtual.paradas.back()));
 
             if (servicosAtendidos >= totalServicos) break;
             if (rotaAtual.paradas.size() > static_cast<size_t>(totalServicos) + 20) {
@@ -625,9 +1434,10 @@ void Grafo::construirESalvarSolucaoVM(const string& nomeInstancia, const string&
         // Verificação para evitar que o algoritmo entre em loop infinito se não conseguir progredir.
         if (!servicoAdicionadoNestaRota && servicosAtendidos < totalServicos) {
             bool algumServicoRestanteViavel = false;
-            for(const auto& s_check : servicosRequeridos) {
-                if (!s_check.atendido && s_check.demanda <= capacidadeVeiculo) {
-                    if (noDeposito >=0 && noDeposito <=numVertices && s_check.u >=0 && s_check.u <=numVertices && dist[noDeposito][s_check.u] != INF) {
+            for (size_t p = 0; p < indices.size(); ++p) {
+                const Servico& s_check = servicosRequeridos[indices[p]];
+                if (!atendido[p] && s_check.demanda <= capacidadeVeiculo) {
+                    if (noDeposito >=0 && noDeposito <=numVertices && s_check.u >=0 && s_check.u <=numVertices && distancia(noDeposito, s_check.u) != INF) {
                         algumServicoRestanteViavel = true;
                         break;
                     }
@@ -640,14 +1450,14 @@ void Grafo::construirESalvarSolucaoVM(const string& nomeInstancia, const string&
         // Se a rota atendeu pelo menos um serviço, é considerada válida.
         if (servicoAdicionadoNestaRota) {
             // Adiciona o custo de regresso ao depósito.
-            int custoParaRetornarAoDeposito = (localizacaoAtual >=0 && localizacaoAtual <=numVertices && noDeposito >=0 && noDeposito <=numVertices) ? dist[localizacaoAtual][noDeposito] : INF;
+            int custoParaRetornarAoDeposito = (localizacaoAtual >=0 && localizacaoAtual <=numVertices && noDeposito >=0 && noDeposito <=numVertices) ? distancia(localizacaoAtual, noDeposito) : INF;
             if (custoParaRetornarAoDeposito == INF) {
                 rotaAtual.custo_total += INF / 2; // Penaliza rotas que não conseguem regressar.
             } else {
                 rotaAtual.custo_total += custoParaRetornarAoDeposito;
             }
             // Finaliza a rota com o regresso ao depósito.
-            rotaAtual.paradas.push_back({'D', "0", noDeposito, noDeposito});
+            rotaAtual.paradas.push_back({'D', "0", noDeposito, noDeposito, -1});
             todasAsRotas.push_back(rotaAtual);
             contadorIdRota++;
         } else if (servicosAtendidos < totalServicos) {
@@ -659,21 +1469,611 @@ void Grafo::construirESalvarSolucaoVM(const string& nomeInstancia, const string&
         }
     }
 
+    return todasAsRotas;
+}
+
+// Executa a heurística construtiva do Vizinho Mais Próximo seguida da melhoria 2-opt.
+Solucao Grafo::resolver() {
+    Solucao solucao;
+
+    // --- Início do processo de construção da solução ---
+    unsigned long long inicio_total_algoritmo_ciclos = __rdtsc();
+    reiniciarPicoMemoriaResidente();
+
+    // Passo 1: Pré-cálculo dos caminhos mínimos, fundamental para a heurística construtiva.
+    // Não dependem das demandas nem das janelas de tempo, por isso uma nova resolução reaproveita-os.
+    if (!distanciasCalculadas) calcularCaminhosMinimosComCustos();
+    unsigned long long fim_caminhos_ciclos = __rdtsc();
+    solucao.memoria_caminhos_kb = picoMemoriaResidenteKB();
+    reiniciarPicoMemoriaResidente();
+
+    // Passo 2: Construção das rotas sobre o conjunto completo de serviços.
+    vector<int> todosOsServicos(servicosRequeridos.size());
+    for (size_t i = 0; i < todosOsServicos.size(); ++i) todosOsServicos[i] = i;
+    vector<Rota>& todasAsRotas = solucao.rotas;
+    todasAsRotas = construirRotas(todosOsServicos);
+
     // Passo 3: Aplicação da heurística de melhoria 2-opt.
+    solucao.memoria_construcao_kb = picoMemoriaResidenteKB();
+    reiniciarPicoMemoriaResidente();
+    unsigned long long inicio_2opt_ciclos = __rdtsc();
     aplicar2Opt(todasAsRotas);
+    unsigned long long fim_2opt_ciclos = __rdtsc();
+    solucao.memoria_2opt_kb = picoMemoriaResidenteKB();
 
     // O custo total da solução é a soma dos custos de todas as rotas otimizadas.
-    long long custoTotalSolucao = 0;
-    for(const auto& rota : todasAsRotas) {
-        custoTotalSolucao += rota.custo_total;
+    for(auto& rota : todasAsRotas) {
+        avaliarTempoRota(rota);
+        solucao.custo_total += rota.custo_total;
+        solucao.penalidade_tempo += rota.atraso_tempo;
     }
 
-    unsigned long long fim_total_algoritmo_ciclos = __rdtsc();
-    unsigned long long ciclos_seu_algoritmo_total = fim_total_algoritmo_ciclos - inicio_total_algoritmo_ciclos;
-    
+    solucao.ciclos = __rdtsc() - inicio_total_algoritmo_ciclos;
+    solucao.ciclos_caminhos = fim_caminhos_ciclos - inicio_total_algoritmo_ciclos;
+    solucao.ciclos_construcao = inicio_2opt_ciclos - fim_caminhos_ciclos;
+    solucao.ciclos_2opt = fim_2opt_ciclos - inicio_2opt_ciclos;
+    return solucao;
+}
+
+// Resolve reutilizando as distâncias já calculadas; o orçamento de tempo limita apenas o 2-opt,
+// porque a construção é necessária para haver uma solução.
+Solucao Grafo::resolverComOrcamento(double orcamentoSegundos, int numThreads) {
+    Solucao solucao;
+    unsigned long long inicio_ciclos = __rdtsc();
+    chrono::steady_clock::time_point prazo = chrono::steady_clock::time_point::max();
+    if (orcamentoSegundos > 0) {
+        prazo = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(orcamentoSegundos));
+    }
+
+    if (!distanciasCalculadas) calcularCaminhosMinimosComCustos();
+    unsigned long long fim_caminhos_ciclos = __rdtsc();
+
+    vector<int> todosOsServicos(servicosRequeridos.size());
+    for (size_t i = 0; i < todosOsServicos.size(); ++i) todosOsServicos[i] = i;
+    solucao.rotas = construirRotas(todosOsServicos);
+    unsigned long long inicio_2opt_ciclos = __rdtsc();
+    aplicar2Opt(solucao.rotas, prazo, numThreads);
+    unsigned long long fim_2opt_ciclos = __rdtsc();
+
+    for (auto& rota : solucao.rotas) {
+        avaliarTempoRota(rota);
+        solucao.custo_total += rota.custo_total;
+        solucao.penalidade_tempo += rota.atraso_tempo;
+    }
+    solucao.ciclos = __rdtsc() - inicio_ciclos;
+    solucao.ciclos_caminhos = fim_caminhos_ciclos - inicio_ciclos;
+    solucao.ciclos_construcao = inicio_2opt_ciclos - fim_caminhos_ciclos;
+    solucao.ciclos_2opt = fim_2opt_ciclos - inicio_2opt_ciclos;
+    return solucao;
+}
+
+int Grafo::numeroGruposDecomposicao() const {
+    int nucleos = max(1u, thread::hardware_concurrency());
+    int porTamanho = (static_cast<int>(servicosRequeridos.size()) + MAX_SERVICOS_GRUPO - 1) / MAX_SERVICOS_GRUPO;
+    return max(nucleos, porTamanho);
+}
+
+// A varredura em profundidade da árvore de caminhos mínimos visita cada subárvore de seguida, pelo que os serviços
+// que partem de um mesmo ramo (a mesma zona da rede, vista do depósito) ficam consecutivos. Os filhos são visitados
+// por ordem de identificador, o que torna a partição determinística.
+vector<vector<int>> Grafo::particionarServicos(int numGrupos) const {
+    const int numServicos = servicosRequeridos.size();
+    numGrupos = max(1, min(numGrupos, numServicos));
+
+    vector<int> inicio, destino, custo;
+    listaAdjacencia(inicio, destino, custo);
+    vector<int> distanciaDeposito(numVertices + 1, INF), pai(numVertices + 1, -1);
+    typedef pair<int, int> EntradaFila; // (distância, vértice)
+    priority_queue<EntradaFila, vector<EntradaFila>, greater<EntradaFila>> fila;
+    if (noDeposito >= 0 && noDeposito <= numVertices) {
+        distanciaDeposito[noDeposito] = 0;
+        fila.push({0, noDeposito});
+    }
+    while (!fila.empty()) {
+        EntradaFila atual = fila.top();
+        fila.pop();
+        int v = atual.second;
+        if (atual.first > distanciaDeposito[v]) continue;
+        for (int a = inicio[v]; a < inicio[v + 1]; ++a) {
+            int candidato = atual.first + custo[a];
+            if (candidato < distanciaDeposito[destino[a]]) {
+                distanciaDeposito[destino[a]] = candidato;
+                pai[destino[a]] = v;
+                fila.push({candidato, destino[a]});
+            }
+        }
+    }
+
+    // Filhos de cada vértice da árvore, em CSR, já por ordem crescente de identificador.
+    vector<int> inicioFilhos(numVertices + 2, 0), filhos;
+    for (int w = 0; w <= numVertices; ++w) if (pai[w] >= 0) inicioFilhos[pai[w] + 1]++;
+    for (int v = 0; v <= numVertices; ++v) inicioFilhos[v + 1] += inicioFilhos[v];
+    filhos.resize(inicioFilhos[numVertices + 1]);
+    vector<int> proximo(inicioFilhos.begin(), inicioFilhos.end() - 1);
+    for (int w = 0; w <= numVertices; ++w) if (pai[w] >= 0) filhos[proximo[pai[w]]++] = w;
+
+    // Posição de cada vértice na varredura; os vértices inalcançáveis a partir do depósito ficam no fim.
+    vector<int> ordem(numVertices + 1, numVertices + 1);
+    vector<int> pilha;
+    if (noDeposito >= 0 && noDeposito <= numVertices) pilha.push_back(noDeposito);
+    int contador = 0;
+    while (!pilha.empty()) {
+        int v = pilha.back();
+        pilha.pop_back();
+        ordem[v] = contador++;
+        for (int k = inicioFilhos[v + 1] - 1; k >= inicioFilhos[v]; --k) pilha.push_back(filhos[k]);
+    }
+
+    vector<int> servicos(numServicos);
+    iota(servicos.begin(), servicos.end(), 0);
+    auto posicao = [&](int idx) {
+        int u = servicosRequeridos[idx].u;
+        return (u >= 0 && u <= numVertices) ? ordem[u] : numVertices + 1;
+    };
+    stable_sort(servicos.begin(), servicos.end(), [&](int a, int b) { return posicao(a) < posicao(b); });
+
+    vector<vector<int>> grupos(numGrupos);
+    for (int g = 0; g < numGrupos; ++g) {
+        size_t de = static_cast<size_t>(g) * numServicos / numGrupos, ate = static_cast<size_t>(g + 1) * numServicos / numGrupos;
+        grupos[g].assign(servicos.begin() + de, servicos.begin() + ate);
+    }
+    return grupos;
+}
+
+// Linhas: depósito e fins dos serviços (de onde o veículo parte); colunas: depósito e inícios (onde chega).
+void Grafo::prepararTabelaGrupo(const vector<int>& indices, TabelaDistanciasGrupo& tabela) const {
+    tabela.linhaDoVertice.assign(numVertices + 1, -1);
+    tabela.colunaDoVertice.assign(numVertices + 1, -1);
+    vector<int> origens, destinos;
+    auto registar = [this](vector<int>& posicao, vector<int>& lista, int v) {
+        if (v >= 0 && v <= numVertices && posicao[v] == -1) {
+            posicao[v] = lista.size();
+            lista.push_back(v);
+        }
+    };
+    registar(tabela.linhaDoVertice, origens, noDeposito);
+    registar(tabela.colunaDoVertice, destinos, noDeposito);
+    for (int idx : indices) {
+        registar(tabela.linhaDoVertice, origens, servicosRequeridos[idx].v);
+        registar(tabela.colunaDoVertice, destinos, servicosRequeridos[idx].u);
+    }
+    hierarquia.tabelaMuitosParaMuitos(origens, destinos, tabela.valores);
+    for (int& d : tabela.valores) if (d >= HierarquiaContracao::INF_HIERARQUIA) d = INF;
+    tabela.colunas = destinos.size();
+}
+
+// Cada grupo termina tipicamente com uma rota pouco carregada (os últimos serviços do Vizinho Mais Próximo).
+// Entre grupos vizinhos na varredura, duas rotas cujas demandas caibam num veículo são unidas quando ligar o fim
+// de uma ao início da outra custa menos do que os dois deslocamentos ao depósito que deixam de ser feitos.
+// As uniões são aplicadas por ordem decrescente de poupança, em rondas, e as rotas unidas passam depois pelo 2-opt,
+// com no máximo `numThreads` threads.
+void Grafo::repararFronteiras(vector<vector<Rota>>& rotasPorGrupo, int numThreads) const {
+    const int numGrupos = rotasPorGrupo.size();
+    if (numGrupos < 2) return;
+    const bool comTempo = restricoesTempoAtivas();
+    vector<SegmentoRota> unitario, prefixo, sufixo;
+    auto penalidadeRota = [&](const Rota& rota) {
+        calcularSegmentos(rota, unitario, prefixo, sufixo);
+        return penalidadeTempo(prefixo.back());
+    };
+    vector<vector<char>> unida(numGrupos);
+    for (int g = 0; g < numGrupos; ++g) unida[g].assign(rotasPorGrupo[g].size(), 0);
+
+    struct Uniao {
+        long long poupanca;
+        int a, b;        // Rota a do grupo g e rota b do grupo h.
+        bool aPrimeiro;  // true: a seguida de b; false: b seguida de a.
+    };
+    // O primeiro e o último grupo também são vizinhos: a varredura dá a volta ao depósito.
+    for (int g = 0; g < numGrupos; ++g) {
+        int h = (g + 1) % numGrupos;
+        if (numGrupos == 2 && g == 1) break;
+        vector<Rota>& rotasG = rotasPorGrupo[g];
+        vector<Rota>& rotasH = rotasPorGrupo[h];
+        vector<char> removida(rotasH.size(), 0);
+
+        bool houveUniao = true;
+        while (houveUniao) {
+            houveUniao = false;
+            vector<Uniao> candidatas;
+            for (size_t a = 0; a < rotasG.size(); ++a) {
+                if (rotasG[a].paradas.size() < 3) continue;
+                for (size_t b = 0; b < rotasH.size(); ++b) {
+                    if (removida[b] || rotasH[b].paradas.size() < 3) continue;
+                    if (rotasG[a].demanda_total + rotasH[b].demanda_total > capacidadeVeiculo) continue;
+                    for (int sentido = 0; sentido < 2; ++sentido) {
+                        const Rota& primeira = sentido == 0 ? rotasG[a] : rotasH[b];
+                        const Rota& segunda = sentido == 0 ? rotasH[b] : rotasG[a];
+                        int fim = primeira.paradas[primeira.paradas.size() - 2].v, comeco = segunda.paradas[1].u;
+                        int ligacao = distancia(fim, comeco), regresso = distancia(fim, noDeposito), partida = distancia(noDeposito, comeco);
+                        if (ligacao == INF || regresso == INF || partida == INF) continue;
+                        long long poupanca = static_cast<long long>(regresso) + partida - ligacao;
+                        if (poupanca > 0) candidatas.push_back({poupanca, static_cast<int>(a), static_cast<int>(b), sentido == 0});
+                    }
+                }
+            }
+            sort(candidatas.begin(), candidatas.end(), [](const Uniao& x, const Uniao& y) {
+                if (x.poupanca != y.poupanca) return x.poupanca > y.poupanca;
+                if (x.a != y.a) return x.a < y.a;
+                return x.b < y.b;
+            });
+
+            vector<char> usadaG(rotasG.size(), 0), usadaH(rotasH.size(), 0);
+            for (const Uniao& u : candidatas) {
+                if (usadaG[u.a] || usadaH[u.b]) continue;
+                const Rota& primeira = u.aPrimeiro ? rotasG[u.a] : rotasH[u.b];
+                const Rota& segunda = u.aPrimeiro ? rotasH[u.b] : rotasG[u.a];
+                Rota juntas = primeira;
+                juntas.paradas.pop_back();
+                juntas.paradas.insert(juntas.paradas.end(), segunda.paradas.begin() + 1, segunda.paradas.end());
+                juntas.demanda_total = primeira.demanda_total + segunda.demanda_total;
+                juntas.custo_total = static_cast<int>(primeira.custo_total + segunda.custo_total - u.poupanca);
+                // Com restrições de tempo, a união não pode piorar a penalidade das duas rotas separadas.
+                if (comTempo && penalidadeRota(juntas) > penalidadeRota(rotasG[u.a]) + penalidadeRota(rotasH[u.b])) continue;
+
+                rotasG[u.a] = juntas;
+                unida[g][u.a] = 1;
+                removida[u.b] = 1;
+                usadaG[u.a] = usadaH[u.b] = 1;
+                houveUniao = true;
+            }
+        }
+
+        // As rotas absorvidas saem do grupo h (mantendo as marcas de união das restantes).
+        vector<Rota> restantes;
+        vector<char> unidaRestantes;
+        for (size_t b = 0; b < rotasH.size(); ++b) {
+            if (removida[b]) continue;
+            restantes.push_back(rotasH[b]);
+            unidaRestantes.push_back(unida[h][b]);
+        }
+        rotasH.swap(restantes);
+        unida[h].swap(unidaRestantes);
+    }
+
+    for (int g = 0; g < numGrupos; ++g) {
+        vector<Rota> unidas;
+        for (size_t r = 0; r < rotasPorGrupo[g].size(); ++r) if (unida[g][r]) unidas.push_back(rotasPorGrupo[g][r]);
+        if (unidas.empty()) continue;
+        aplicar2Opt(unidas, chrono::steady_clock::time_point::max(), numThreads);
+        size_t proxima = 0;
+        for (size_t r = 0; r < rotasPorGrupo[g].size(); ++r) if (unida[g][r]) rotasPorGrupo[g][r] = unidas[proxima++];
+    }
+}
+
+// Os grupos são distribuídos dinamicamente pelas threads (grupos maiores do que o número de threads equilibram
+// a carga). Os ciclos de construção incluem o 2-opt dentro de cada grupo; os ciclos de 2-opt medem a reparação
+// das fronteiras.
+Solucao Grafo::resolverDecomposto(int numGrupos, int numThreads) {
+    Solucao solucao;
+    unsigned long long inicio_total_algoritmo_ciclos = __rdtsc();
+    reiniciarPicoMemoriaResidente();
+
+    if (!distanciasCalculadas) calcularCaminhosMinimosComCustos();
+    unsigned long long fim_caminhos_ciclos = __rdtsc();
+    solucao.memoria_caminhos_kb = picoMemoriaResidenteKB();
+    reiniciarPicoMemoriaResidente();
+
+    vector<vector<int>> grupos = particionarServicos(numGrupos);
+    if (numThreads <= 0) numThreads = max(1u, thread::hardware_concurrency());
+    numThreads = min(numThreads, static_cast<int>(grupos.size()));
+
+    vector<vector<Rota>> rotasPorGrupo(grupos.size());
+    atomic<size_t> proximoGrupo(0);
+    vector<thread> trabalhadores;
+    for (int t = 0; t < numThreads; ++t) {
+        trabalhadores.emplace_back([this, &grupos, &rotasPorGrupo, &proximoGrupo]() {
+            TabelaDistanciasGrupo tabela;
+            for (size_t g = proximoGrupo++; g < grupos.size(); g = proximoGrupo++) {
+                if (representacao == REPR_HIERARQUIA) {
+                    prepararTabelaGrupo(grupos[g], tabela);
+                    tabelaGrupo = &tabela;
+                }
+                rotasPorGrupo[g] = construirRotas(grupos[g]);
+                aplicar2Opt(rotasPorGrupo[g], chrono::steady_clock::time_point::max(), 1);
+                tabelaGrupo = nullptr;
+            }
+        });
+    }
+    for (thread& t : trabalhadores) t.join();
+
+    solucao.memoria_construcao_kb = picoMemoriaResidenteKB();
+    reiniciarPicoMemoriaResidente();
+    unsigned long long inicio_2opt_ciclos = __rdtsc();
+    repararFronteiras(rotasPorGrupo, numThreads);
+    unsigned long long fim_2opt_ciclos = __rdtsc();
+    solucao.memoria_2opt_kb = picoMemoriaResidenteKB();
+
+    int contadorIdRota = 1;
+    for (vector<Rota>& rotas : rotasPorGrupo) {
+        for (Rota& rota : rotas) {
+            rota.id_rota = contadorIdRota++;
+            avaliarTempoRota(rota);
+            solucao.custo_total += rota.custo_total;
+            solucao.penalidade_tempo += rota.atraso_tempo;
+            solucao.rotas.push_back(rota);
+        }
+    }
+
+    solucao.ciclos = __rdtsc() - inicio_total_algoritmo_ciclos;
+    solucao.ciclos_caminhos = fim_caminhos_ciclos - inicio_total_algoritmo_ciclos;
+    solucao.ciclos_construcao = inicio_2opt_ciclos - fim_caminhos_ciclos;
+    solucao.ciclos_2opt = fim_2opt_ciclos - inicio_2opt_ciclos;
+    return solucao;
+}
+
+// Número de dias do horizonte de planeamento da instância.
+int Grafo::numeroDias() const {
+    return numDias;
+}
+
+// Atribuição gulosa de dias: os serviços com menos alternativas são decididos primeiro e cada um recebe a combinação
+// com menor custo estimado, somando, em cada dia, o deslocamento a partir do serviço mais próximo já atribuído
+// e a ida e volta ao depósito sempre que a carga do dia passa a exigir mais um veículo.
+vector<unsigned int> Grafo::atribuirDias() const {
+    int totalServicos = servicosRequeridos.size();
+    vector<unsigned int> escolha(totalServicos, 0);
+    vector<long long> cargaPorDia(numDias, 0);
+    vector<vector<int>> atribuidosPorDia(numDias);
+
+    vector<int> ordem(totalServicos);
+    for (int i = 0; i < totalServicos; ++i) ordem[i] = i;
+    stable_sort(ordem.begin(), ordem.end(), [this](int a, int b) {
+        const Servico& sa = servicosRequeridos[a];
+        const Servico& sb = servicosRequeridos[b];
+        if (sa.combinacoes_dias.size() != sb.combinacoes_dias.size()) return sa.combinacoes_dias.size() < sb.combinacoes_dias.size();
+        return static_cast<long long>(sa.demanda) * sa.frequencia > static_cast<long long>(sb.demanda) * sb.frequencia;
+    });
+
+    vector<long long> custoPorDia(numDias);
+    for (int i : ordem) {
+        const Servico& s = servicosRequeridos[i];
+
+        // Custo estimado de acrescentar o serviço a cada dia, calculado uma única vez para todas as combinações.
+        for (int d = 0; d < numDias; ++d) {
+            long long proximidade = distancia(noDeposito, s.u);
+            for (int j : atribuidosPorDia[d]) {
+                proximidade = min(proximidade, static_cast<long long>(min(distancia(servicosRequeridos[j].v, s.u), distancia(s.v, servicosRequeridos[j].u))));
+            }
+            long long veiculosAntes = (cargaPorDia[d] + capacidadeVeiculo - 1) / capacidadeVeiculo;
+            long long veiculosDepois = (cargaPorDia[d] + s.demanda + capacidadeVeiculo - 1) / capacidadeVeiculo;
+            long long novoVeiculo = (veiculosDepois > veiculosAntes) ? static_cast<long long>(distancia(noDeposito, s.u)) + distancia(s.v, noDeposito) : 0;
+            custoPorDia[d] = proximidade + novoVeiculo;
+        }
+
+        long long melhorCusto = -1, melhorCarga = 0;
+        for (unsigned int mascara : s.combinacoes_dias) {
+            long long custo = 0, cargaMaxima = 0;
+            for (int d = 0; d < numDias; ++d) {
+                if (mascara & (1u << d)) {
+                    custo += custoPorDia[d];
+                    cargaMaxima = max(cargaMaxima, cargaPorDia[d]);
+                }
+            }
+            // Em caso de empate, prefere a combinação cujos dias estão menos carregados.
+            if (melhorCusto == -1 || custo < melhorCusto || (custo == melhorCusto && cargaMaxima < melhorCarga)) {
+                melhorCusto = custo;
+                melhorCarga = cargaMaxima;
+                escolha[i] = mascara;
+            }
+        }
+
+        for (int d = 0; d < numDias; ++d) {
+            if (escolha[i] & (1u << d)) {
+                cargaPorDia[d] += s.demanda;
+                atribuidosPorDia[d].push_back(i);
+            }
+        }
+    }
+    return escolha;
+}
+
+// Segmentos pré-calculados de uma rota, invalidados sempre que a rota é alterada.
+struct SegmentosEmCache {
+    vector<SegmentoRota> unitario, prefixo, sufixo;
+    bool valido = false;
+};
+
+// Busca local sobre a atribuição de dias: para cada serviço com alternativas, avalia trocar a combinação atual
+// removendo as visitas dos dias que saem e inserindo-as na melhor posição viável dos dias que entram.
+// Cada remoção e cada posição de inserção custam O(1) graças aos prefixos e sufixos em cache.
+void Grafo::refinarAtribuicaoDias(vector<unsigned int>& escolha, vector<vector<Rota>>& rotasPorDia) const {
+    vector<vector<SegmentosEmCache>> cache(numDias);
+    auto segmentos = [&](int d, size_t r) -> SegmentosEmCache& {
+        if (cache[d].size() != rotasPorDia[d].size()) cache[d].assign(rotasPorDia[d].size(), SegmentosEmCache());
+        SegmentosEmCache& c = cache[d][r];
+        if (!c.valido) {
+            calcularSegmentos(rotasPorDia[d][r], c.unitario, c.prefixo, c.sufixo);
+            c.valido = true;
+        }
+        return c;
+    };
+
+    // Remoção ou inserção de uma visita: dia, rota, posição na rota e variação de custo.
+    struct AlteracaoDia { int dia; size_t rota; size_t posicao; long long delta; };
+
+    bool melhorou = true;
+    for (int passagem = 0; melhorou && passagem < MAX_PASSES_PERIODICO; ++passagem) {
+        melhorou = false;
+        for (size_t i = 0; i < servicosRequeridos.size(); ++i) {
+            const Servico& s = servicosRequeridos[i];
+            if (s.combinacoes_dias.size() < 2) continue;
+            SegmentoRota unidade = segmentoDaParada({'S', "", s.u, s.v, static_cast<int>(i)});
+
+            long long melhorDelta = 0;
+            unsigned int melhorMascara = escolha[i];
+            vector<AlteracaoDia> melhoresRemocoes;
+            vector<AlteracaoDia> melhoresInsercoes;
+
+            for (unsigned int alternativa : s.combinacoes_dias) {
+                if (alternativa == escolha[i]) continue;
+                unsigned int sai = escolha[i] & ~alternativa;
+                unsigned int entra = alternativa & ~escolha[i];
+                long long delta = 0;
+                bool viavel = true;
+                vector<AlteracaoDia> remocoes;
+                vector<AlteracaoDia> insercoes;
+
+                for (int d = 0; d < numDias && viavel; ++d) {
+                    if (!(sai & (1u << d))) continue;
+                    // Localiza a visita do serviço nas rotas do dia e avalia a rota sem ela.
+                    bool encontrado = false;
+                    for (size_t r = 0; r < rotasPorDia[d].size() && !encontrado; ++r) {
+                        const vector<ParadaRota>& paradas = rotasPorDia[d][r].paradas;
+                        for (size_t k = 1; k + 1 < paradas.size(); ++k) {
+                            if (paradas[k].idx_servico != static_cast<int>(i)) continue;
+                            SegmentosEmCache& c = segmentos(d, r);
+                            const SegmentoRota& atual = c.prefixo.back();
+                            SegmentoRota semServico = concatenarSegmentos(c.prefixo[k-1], c.sufixo[k+1]);
+                            if (atual.custo >= INF || penalidadeTempo(semServico) > penalidadeTempo(atual)) {
+                                viavel = false;
+                            } else {
+                                remocoes.push_back({d, r, k, semServico.custo - atual.custo});
+                                delta += semServico.custo - atual.custo;
+                            }
+                            encontrado = true;
+                            break;
+                        }
+                    }
+                    if (!encontrado) viavel = false;
+                }
+
+                for (int d = 0; d < numDias && viavel; ++d) {
+                    if (!(entra & (1u << d))) continue;
+                    // Melhor posição de inserção entre as rotas do dia com capacidade disponível.
+                    AlteracaoDia melhor = {d, 0, 0, -1};
+                    bool existe = false;
+                    for (size_t r = 0; r < rotasPorDia[d].size(); ++r) {
+                        if (rotasPorDia[d][r].demanda_total + s.demanda > capacidadeVeiculo) continue;
+                        SegmentosEmCache& c = segmentos(d, r);
+                        const SegmentoRota& atual = c.prefixo.back();
+                        if (atual.custo >= INF) continue;
+                        long long penalidadeAtual = penalidadeTempo(atual);
+                        for (size_t k = 0; k + 1 < c.prefixo.size(); ++k) {
+                            SegmentoRota comServico = concatenarSegmentos(concatenarSegmentos(c.prefixo[k], unidade), c.sufixo[k+1]);
+                            if (comServico.custo >= INF || penalidadeTempo(comServico) > penalidadeAtual) continue;
+                            long long d_custo = comServico.custo - atual.custo;
+                            if (!existe || d_custo < melhor.delta) {
+                                melhor = {d, r, k + 1, d_custo};
+                                existe = true;
+                            }
+                        }
+                    }
+                    if (!existe) {
+                        viavel = false;
+                    } else {
+                        insercoes.push_back(melhor);
+                        delta += melhor.delta;
+                    }
+                }
+
+                if (viavel && delta < melhorDelta) {
+                    melhorDelta = delta;
+                    melhorMascara = alternativa;
+                    melhoresRemocoes.swap(remocoes);
+                    melhoresInsercoes.swap(insercoes);
+                }
+            }
+
+            if (melhorMascara == escolha[i]) continue;
+
+            // Aplica a troca: dias distintos não interferem entre si, pelo que as posições calculadas continuam válidas.
+            for (const AlteracaoDia& rem : melhoresRemocoes) {
+                Rota& rota = rotasPorDia[rem.dia][rem.rota];
+                rota.paradas.erase(rota.paradas.begin() + rem.posicao);
+                rota.custo_total += rem.delta;
+                rota.demanda_total -= s.demanda;
+                cache[rem.dia][rem.rota].valido = false;
+                if (rota.paradas.size() <= 2) {
+                    rotasPorDia[rem.dia].erase(rotasPorDia[rem.dia].begin() + rem.rota);
+                    cache[rem.dia].clear();
+                }
+            }
+            for (const AlteracaoDia& ins : melhoresInsercoes) {
+                Rota& rota = rotasPorDia[ins.dia][ins.rota];
+                rota.paradas.insert(rota.paradas.begin() + ins.posicao, {'S', to_string(s.id_numerico_sequencial), s.u, s.v, static_cast<int>(i)});
+                rota.custo_total += ins.delta;
+                rota.demanda_total += s.demanda;
+                cache[ins.dia][ins.rota].valido = false;
+            }
+            escolha[i] = melhorMascara;
+            melhorou = true;
+        }
+    }
+}
+
+// Resolve o problema periódico: atribuição de dias, construção e 2-opt de cada dia numa thread própria
+// (a matriz de distâncias é partilhada apenas para leitura) e refinamento conjunto da atribuição.
+Solucao Grafo::resolverPeriodico() {
+    Solucao solucao;
+    unsigned long long inicio_total_algoritmo_ciclos = __rdtsc();
+    reiniciarPicoMemoriaResidente();
+
+    // Passo 1: Caminhos mínimos, partilhados por todos os dias (reaproveitados se já calculados).
+    if (!distanciasCalculadas) calcularCaminhosMinimosComCustos();
+    unsigned long long fim_caminhos_ciclos = __rdtsc();
+    solucao.memoria_caminhos_kb = picoMemoriaResidenteKB();
+    reiniciarPicoMemoriaResidente();
+
+    // Passo 2: Atribuição inicial de dias e construção paralela das rotas de cada dia.
+    vector<unsigned int> escolha = atribuirDias();
+    vector<vector<int>> indicesPorDia(numDias);
+    for (size_t i = 0; i < servicosRequeridos.size(); ++i) {
+        for (int d = 0; d < numDias; ++d) {
+            if (escolha[i] & (1u << d)) indicesPorDia[d].push_back(i);
+        }
+    }
+
+    vector<vector<Rota>> rotasPorDia(numDias);
+    vector<thread> trabalhadores;
+    for (int d = 0; d < numDias; ++d) {
+        trabalhadores.emplace_back([this, d, &indicesPorDia, &rotasPorDia]() {
+            rotasPorDia[d] = construirRotas(indicesPorDia[d]);
+        });
+    }
+    for (thread& t : trabalhadores) t.join();
+
+    // Passo 3: Refinamento conjunto da atribuição de dias sobre as rotas construídas.
+    refinarAtribuicaoDias(escolha, rotasPorDia);
+
+    // Passo 4: 2-opt de cada dia em paralelo.
+    solucao.memoria_construcao_kb = picoMemoriaResidenteKB();
+    reiniciarPicoMemoriaResidente();
+    unsigned long long inicio_2opt_ciclos = __rdtsc();
+    trabalhadores.clear();
+    for (int d = 0; d < numDias; ++d) {
+        trabalhadores.emplace_back([this, d, &rotasPorDia]() {
+            aplicar2Opt(rotasPorDia[d], chrono::steady_clock::time_point::max(), 1);
+        });
+    }
+    for (thread& t : trabalhadores) t.join();
+    unsigned long long fim_2opt_ciclos = __rdtsc();
+    solucao.memoria_2opt_kb = picoMemoriaResidenteKB();
+
+    // As rotas de todos os dias recebem uma numeração única e o dia em que são executadas.
+    int contadorIdRota = 1;
+    for (int d = 0; d < numDias; ++d) {
+        for (Rota& rota : rotasPorDia[d]) {
+            rota.id_rota = contadorIdRota++;
+            rota.dia = d + 1;
+            avaliarTempoRota(rota);
+            solucao.custo_total += rota.custo_total;
+            solucao.penalidade_tempo += rota.atraso_tempo;
+            solucao.rotas.push_back(rota);
+        }
+    }
+
+    solucao.ciclos = __rdtsc() - inicio_total_algoritmo_ciclos;
+    solucao.ciclos_caminhos = fim_caminhos_ciclos - inicio_total_algoritmo_ciclos;
+    solucao.ciclos_construcao = inicio_2opt_ciclos - fim_caminhos_ciclos;
+    solucao.ciclos_2opt = fim_2opt_ciclos - inicio_2opt_ciclos;
+    return solucao;
+}
+
+// Escreve a solução no ficheiro de saída, conforme o formato especificado.
+void Grafo::salvarSolucao(const Solucao& solucao, const string& nomeInstancia, const string& pastaDeSaida) {
     long long clock_ref_melhor_sol_csv = lerClockRefDoCSV(nomeInstancia, 4);
 
-    // Passo 4: Escrita da solução final no ficheiro de saída, conforme o formato especificado.
     string nomeArquivoSaida = pastaDeSaida + "/sol-" + nomeInstancia + ".dat";
     ofstream arquivoSaida(nomeArquivoSaida);
 
@@ -682,25 +2082,397 @@ void Grafo::construirESalvarSolucaoVM(const string& nomeInstancia, const string&
         return;
     }
 
-    arquivoSaida << custoTotalSolucao << endl;
-    arquivoSaida << todasAsRotas.size() << endl;
-    arquivoSaida << ciclos_seu_algoritmo_total << endl;
+    arquivoSaida << solucao.custo_total << endl;
+    arquivoSaida << solucao.rotas.size() << endl;
+    arquivoSaida << solucao.ciclos << endl;
     arquivoSaida << clock_ref_melhor_sol_csv << endl; 
 
-    // Escreve os detalhes de cada rota no ficheiro.
-    for (const auto& rota : todasAsRotas) {
-        arquivoSaida << 0 << " 1 "
-                     << rota.id_rota << " "
-                     << rota.demanda_total << " "
-                     << rota.custo_total << " "
-                     << rota.paradas.size();
+    escreverRotas(arquivoSaida, solucao);
+    arquivoSaida.close();
+}
+
+// Escreve os detalhes de cada rota: depósito, dia, id, demanda, custo, número de paragens e as paragens.
+void Grafo::escreverRotas(ostream& saida, const Solucao& solucao) const {
+    for (const auto& rota : solucao.rotas) {
+        saida << 0 << " " << rota.dia << " "
+              << rota.id_rota << " "
+              << rota.demanda_total << " "
+              << rota.custo_total << " "
+              << rota.paradas.size();
         for (const auto& parada : rota.paradas) {
-            arquivoSaida << " (" << parada.tipo_parada << " "
-                         << parada.id_servico << ","
-                         << parada.u << ","
-                         << parada.v << ")";
+            saida << " (" << parada.tipo_parada << " "
+                  << parada.id_servico << ","
+                  << parada.u << ","
+                  << parada.v << ")";
         }
-        arquivoSaida << endl;
+        saida << endl;
     }
-    arquivoSaida.close();
+}
+
+// Método principal que coordena a construção da solução, a sua otimização e o armazenamento do resultado.
+void Grafo::construirESalvarSolucaoVM(const string& nomeInstancia, const string& pastaDeSaida) {
+    // Verificações de pré-condições para a execução.
+    if (numVertices == 0 || (noDeposito == 0 && numVertices > 0) ) {
+        cerr << "AVISO: Dados insuficientes para construir solucao para " << nomeInstancia << ". Abortando." << endl;
+        return;
+    }
+    // Caso trivial: se não há serviços, a solução tem custo zero e nenhuma rota.
+    if (servicosRequeridos.empty()) {
+        string nomeArquivoSaida = pastaDeSaida + "/sol-" + nomeInstancia + ".dat";
+        ofstream arquivoSaida(nomeArquivoSaida);
+        if (arquivoSaida.is_open()) {
+            unsigned long long inicio_total_algoritmo_ciclos_vazio = __rdtsc();
+            unsigned long long fim_vazio_ciclos = __rdtsc();
+            arquivoSaida << "0" << endl;
+            arquivoSaida << "0" << endl;
+            arquivoSaida << (fim_vazio_ciclos - inicio_total_algoritmo_ciclos_vazio) << endl;
+            arquivoSaida << lerClockRefDoCSV(nomeInstancia, 4) << endl;
+            arquivoSaida.close();
+        }
+        return;
+    }
+
+    if (capacidadeVeiculo <= 0) {
+        cerr << "AVISO: Capacidade do veiculo invalida (" << capacidadeVeiculo << ") para " << nomeInstancia << ". Abortando." << endl;
+        return;
+    }
+
+    Solucao solucao;
+    if (numDias > 1) solucao = resolverPeriodico();
+    else if (servicosRequeridos.size() >= static_cast<size_t>(LIMIAR_DECOMPOSICAO)) solucao = resolverDecomposto(numeroGruposDecomposicao());
+    else solucao = resolver();
+    if (solucao.penalidade_tempo > 0) {
+        cerr << "AVISO: A solucao de " << nomeInstancia << " viola restricoes de tempo (penalidade "
+             << solucao.penalidade_tempo << ")." << endl;
+    }
+
+    // Passo 4: Escrita da solução final no ficheiro de saída.
+    salvarSolucao(solucao, nomeInstancia, pastaDeSaida);
+    if (formatoRotasExpandidas != ROTAS_EXPANDIDAS_NENHUMA) salvarRotasExpandidas(solucao, nomeInstancia, pastaDeSaida, formatoRotasExpandidas);
+}
+
+// Buffer de escrita próprio: os números são formatados à mão e o buffer só é entregue ao ostream quando enche,
+// evitando o custo do operator<< por vértice.
+class EscritorRotas {
+public:
+    explicit EscritorRotas(ostream& saida) : saida(saida), usado(0) {}
+    ~EscritorRotas() { despejar(); }
+
+    void caractere(char c) {
+        if (usado == sizeof(buffer)) despejar();
+        buffer[usado++] = c;
+    }
+    void texto(const char* s, size_t n) {
+        for (size_t i = 0; i < n; ++i) caractere(s[i]);
+    }
+    void inteiro(long long valor) {
+        char digitos[24];
+        int n = 0;
+        unsigned long long x = valor < 0 ? 0ULL - static_cast<unsigned long long>(valor) : static_cast<unsigned long long>(valor);
+        do {
+            digitos[n++] = static_cast<char>('0' + x % 10);
+            x /= 10;
+        } while (x != 0);
+        if (valor < 0) caractere('-');
+        while (n > 0) caractere(digitos[--n]);
+    }
+    // Inteiro sem sinal em grupos de 7 bits, do menos para o mais significativo; o bit alto indica continuação.
+    void varint(uint64_t valor) {
+        while (valor >= 0x80) {
+            caractere(static_cast<char>((valor & 0x7F) | 0x80));
+            valor >>= 7;
+        }
+        caractere(static_cast<char>(valor));
+    }
+    // Zigzag (0, -1, 1, -2, ... -> 0, 1, 2, 3, ...): diferenças pequenas de qualquer sinal ocupam um só byte.
+    void varintComSinal(long long valor) {
+        varint((static_cast<uint64_t>(valor) << 1) ^ static_cast<uint64_t>(valor >> 63));
+    }
+    void despejar() {
+        saida.write(buffer, usado);
+        usado = 0;
+    }
+
+private:
+    ostream& saida;
+    char buffer[1 << 16];
+    size_t usado;
+};
+
+// Dijkstra sobre a rede em CSR a partir de `origem`, registando em pai[] a árvore de caminhos mínimos, até fixar
+// `alvo` (-1 percorre toda a rede). Devolve se o alvo foi alcançado; `alcancados` lista os vértices a repor.
+static bool crescerArvore(int origem, int alvo, const vector<int>& inicio, const vector<int>& destino, const vector<int>& custo,
+                          vector<int>& distancia, vector<int>& pai, vector<int>& alcancados) {
+    typedef pair<int, int> EntradaFila; // (distância, vértice)
+    priority_queue<EntradaFila, vector<EntradaFila>, greater<EntradaFila>> fila;
+    distancia[origem] = 0;
+    alcancados.push_back(origem);
+    fila.push({0, origem});
+    while (!fila.empty()) {
+        EntradaFila atual = fila.top();
+        fila.pop();
+        int v = atual.second;
+        if (atual.first > distancia[v]) continue;
+        if (v == alvo) return true;
+        for (int a = inicio[v]; a < inicio[v + 1]; ++a) {
+            int w = destino[a];
+            int candidato = atual.first + custo[a];
+            if (candidato < distancia[w]) {
+                if (distancia[w] == INF) alcancados.push_back(w);
+                distancia[w] = candidato;
+                pai[w] = v;
+                fila.push({candidato, w});
+            }
+        }
+    }
+    return alvo == -1;
+}
+
+// Sem matriz de predecessores, os deslocamentos que partem do depósito ou regressam a ele (dois por rota) usam
+// duas árvores completas calculadas uma única vez: a árvore de caminhos mínimos a partir do depósito e a árvore
+// para o depósito (sobre a rede invertida). Os restantes são pesquisas de Dijkstra a partir da origem que param ao
+// fixar o destino; como o Vizinho Mais Próximo escolhe serviços próximos, essas árvores crescem pouco.
+struct EspacoExpansao {
+    vector<int> caminho; // Caminho do deslocamento atual, do destino para trás; reutilizado por todas as rotas.
+    vector<int> inicio, destino, custo;
+    vector<int> distancia, pai, alcancados; // Árvore parcial do deslocamento atual.
+    vector<int> paiDeposito;                // Predecessor de cada vértice no caminho mínimo a partir do depósito.
+    vector<int> seguinteParaDeposito;       // Vértice seguinte no caminho mínimo de cada vértice até ao depósito.
+
+    void repor() {
+        for (int v : alcancados) {
+            distancia[v] = INF;
+            pai[v] = -1;
+        }
+        alcancados.clear();
+    }
+};
+
+void Grafo::caminhoInvertido(int origem, int destino, EspacoExpansao& espaco) const {
+    const size_t tamanhoInicial = espaco.caminho.size();
+    if (representacao == REPR_DENSA) {
+        int atual = destino;
+        while (atual != origem) {
+            espaco.caminho.push_back(atual);
+            uint16_t anterior = pred(origem, atual);
+            if (anterior == SEM_PREDECESSOR || espaco.caminho.size() - tamanhoInicial > static_cast<size_t>(numVertices)) {
+                // Sem caminho: fica apenas o destino, para que as paragens continuem na sequência.
+                espaco.caminho.resize(tamanhoInicial);
+                espaco.caminho.push_back(destino);
+                return;
+            }
+            atual = anterior;
+        }
+        return;
+    }
+
+    if (espaco.inicio.empty()) {
+        espaco.distancia.assign(numVertices + 1, INF);
+        espaco.pai.assign(numVertices + 1, -1);
+        vector<int> inicioInvertida, destinoInvertida, custoInvertida;
+        listaAdjacencia(inicioInvertida, destinoInvertida, custoInvertida, true);
+        crescerArvore(noDeposito, -1, inicioInvertida, destinoInvertida, custoInvertida, espaco.distancia, espaco.pai, espaco.alcancados);
+        espaco.seguinteParaDeposito = espaco.pai;
+        espaco.repor();
+        listaAdjacencia(espaco.inicio, espaco.destino, espaco.custo);
+        crescerArvore(noDeposito, -1, espaco.inicio, espaco.destino, espaco.custo, espaco.distancia, espaco.pai, espaco.alcancados);
+        espaco.paiDeposito = espaco.pai;
+        espaco.repor();
+    }
+
+    if (origem == noDeposito) {
+        for (int v = destino; v != origem && v != -1; v = espaco.paiDeposito[v]) espaco.caminho.push_back(v);
+    } else if (destino == noDeposito) {
+        for (int v = espaco.seguinteParaDeposito[origem]; v != -1; v = v == destino ? -1 : espaco.seguinteParaDeposito[v]) {
+            espaco.caminho.push_back(v);
+        }
+        reverse(espaco.caminho.begin() + tamanhoInicial, espaco.caminho.end());
+    } else if (crescerArvore(origem, destino, espaco.inicio, espaco.destino, espaco.custo, espaco.distancia, espaco.pai, espaco.alcancados)) {
+        for (int v = destino; v != origem; v = espaco.pai[v]) espaco.caminho.push_back(v);
+        espaco.repor();
+    } else {
+        espaco.repor();
+    }
+    // Sem caminho: fica apenas o destino, para que as paragens continuem na sequência.
+    if (espaco.caminho.size() == tamanhoInicial || espaco.caminho[tamanhoInicial] != destino) {
+        espaco.caminho.resize(tamanhoInicial);
+        espaco.caminho.push_back(destino);
+    }
+}
+
+// A rota parte do depósito; cada paragem acrescenta o deslocamento até ao seu início e, se for uma aresta ou um
+// arco, a própria ligação atendida (u -> v).
+template <class Emitir>
+void Grafo::expandirRota(const Rota& rota, EspacoExpansao& espaco, Emitir emitir) const {
+    if (rota.paradas.empty()) return;
+    int atual = rota.paradas.front().u;
+    emitir(atual);
+    for (size_t i = 1; i < rota.paradas.size(); ++i) {
+        const ParadaRota& parada = rota.paradas[i];
+        if (parada.u != atual) {
+            espaco.caminho.clear();
+            caminhoInvertido(atual, parada.u, espaco);
+            for (size_t k = espaco.caminho.size(); k-- > 0;) emitir(espaco.caminho[k]);
+        }
+        if (parada.v != parada.u) emitir(parada.v);
+        atual = parada.v;
+    }
+}
+
+void Grafo::definirRotasExpandidas(FormatoRotasExpandidas formato) {
+    formatoRotasExpandidas = formato;
+}
+
+// Formato binário: a assinatura "MCGRPRX1", o número de rotas (varint) e, por rota, o dia e o id (varint) seguidos
+// das diferenças entre vértices consecutivos (varint zigzag, a partir de 0). Como dois vértices consecutivos nunca
+// são iguais, a diferença 0 termina a rota.
+void Grafo::salvarRotasExpandidas(const Solucao& solucao, const string& nomeInstancia, const string& pastaDeSaida,
+                                  FormatoRotasExpandidas formato) const {
+    if (formato == ROTAS_EXPANDIDAS_NENHUMA) return;
+    const bool binario = formato == ROTAS_EXPANDIDAS_BINARIO;
+    string nomeArquivoSaida = pastaDeSaida + "/rotas-" + nomeInstancia + (binario ? ".bin" : ".txt");
+    ofstream arquivoSaida(nomeArquivoSaida, binario ? ios::binary : ios::out);
+    if (!arquivoSaida.is_open()) {
+        cerr << "Erro ao criar o ficheiro de saida: " << nomeArquivoSaida << endl;
+        return;
+    }
+
+    EspacoExpansao espaco;
+    EscritorRotas escritor(arquivoSaida);
+    if (binario) {
+        escritor.texto("MCGRPRX1", 8);
+        escritor.varint(solucao.rotas.size());
+    }
+    for (const Rota& rota : solucao.rotas) {
+        int anterior = 0;
+        bool primeiro = true;
+        if (binario) {
+            escritor.varint(rota.dia);
+            escritor.varint(rota.id_rota);
+        } else {
+            escritor.inteiro(rota.dia);
+            escritor.caractere(' ');
+            escritor.inteiro(rota.id_rota);
+        }
+        expandirRota(rota, espaco, [&](int v) {
+            if (!primeiro && v == anterior) return;
+            if (binario) {
+                escritor.varintComSinal(static_cast<long long>(v) - anterior);
+            } else {
+                escritor.caractere(' ');
+                escritor.inteiro(v);
+            }
+            anterior = v;
+            primeiro = false;
+        });
+        if (binario) escritor.varint(0);
+        else escritor.caractere('\n');
+    }
+}
+
+VerificacaoSolucao Grafo::verificarSolucao(const Solucao& solucao, bool custoComAtendimento) const {
+    VerificacaoSolucao verificacao;
+    const int numServicos = servicosRequeridos.size();
+    vector<int> indicePorId;
+    for (int i = 0; i < numServicos; ++i) {
+        int id = servicosRequeridos[i].id_numerico_sequencial;
+        if (id >= static_cast<int>(indicePorId.size())) indicePorId.resize(id + 1, -1);
+        indicePorId[id] = i;
+    }
+
+    // Sem distâncias pré-calculadas, os deslocamentos de e para o depósito usam as duas árvores completas do depósito
+    // e os restantes uma pesquisa de Dijkstra que para ao fixar o destino, como na expansão das rotas.
+    vector<int> inicio, destino, custo, distanciaArvore, pai, alcancados, desdeDeposito, paraDeposito;
+    auto deslocamento = [&](int a, int b) -> long long {
+        if (a == b) return 0;
+        if (distanciasCalculadas) return distancia(a, b);
+        if (inicio.empty()) {
+            distanciaArvore.assign(numVertices + 1, INF);
+            pai.assign(numVertices + 1, -1);
+            listaAdjacencia(inicio, destino, custo, true);
+            crescerArvore(noDeposito, -1, inicio, destino, custo, distanciaArvore, pai, alcancados);
+            paraDeposito = distanciaArvore;
+            for (int v : alcancados) distanciaArvore[v] = INF;
+            alcancados.clear();
+            listaAdjacencia(inicio, destino, custo);
+            crescerArvore(noDeposito, -1, inicio, destino, custo, distanciaArvore, pai, alcancados);
+            desdeDeposito = distanciaArvore;
+            for (int v : alcancados) distanciaArvore[v] = INF;
+            alcancados.clear();
+        }
+        if (a == noDeposito) return desdeDeposito[b];
+        if (b == noDeposito) return paraDeposito[a];
+        long long d = crescerArvore(a, b, inicio, destino, custo, distanciaArvore, pai, alcancados) ? distanciaArvore[b] : INF;
+        for (int v : alcancados) distanciaArvore[v] = INF;
+        alcancados.clear();
+        return d;
+    };
+
+    vector<int> visitas(numServicos, 0);
+    vector<unsigned int> diasDoServico(numServicos, 0);
+    long long somaCustosDeclarados = 0;
+    for (const Rota& rota : solucao.rotas) {
+        somaCustosDeclarados += rota.custo_total;
+        const bool diaValido = rota.dia >= 1 && rota.dia <= numDias;
+        if (!diaValido) verificacao.dias_invalidos++;
+
+        long long custoRota = 0, demandaRota = 0;
+        int atual = noDeposito;
+        for (size_t p = 0; p < rota.paradas.size(); ++p) {
+            const ParadaRota& parada = rota.paradas[p];
+            const bool ponta = p == 0 || p + 1 == rota.paradas.size();
+            // As rotas começam e terminam no depósito e só o visitam nas pontas.
+            if (parada.tipo_parada == 'D' || ponta) {
+                if (parada.tipo_parada != 'D' || !ponta) verificacao.paragens_invalidas++;
+                if (parada.tipo_parada == 'D') continue;
+            }
+
+            char* fimId = nullptr;
+            long id = strtol(parada.id_servico.c_str(), &fimId, 10);
+            int idx = parada.tipo_parada == 'S' && *fimId == '\0' && id >= 0 && id < static_cast<long>(indicePorId.size()) ? indicePorId[id] : -1;
+            if (idx < 0) {
+                verificacao.paragens_invalidas++;
+                continue;
+            }
+            const Servico& servico = servicosRequeridos[idx];
+            bool extremidadesCorretas = (parada.u == servico.u && parada.v == servico.v) ||
+                                        (servico.tipo == Servico::ARESTA && parada.u == servico.v && parada.v == servico.u);
+            if (!extremidadesCorretas || parada.u < 1 || parada.u > numVertices || parada.v < 1 || parada.v > numVertices) {
+                verificacao.paragens_invalidas++;
+                continue;
+            }
+
+            long long d = deslocamento(atual, parada.u);
+            if (d >= INF) verificacao.ligacoes_inalcancaveis++;
+            else custoRota += d;
+            custoRota += servico.custo_percurso + (custoComAtendimento ? servico.custo_servico : 0);
+            verificacao.custo_atendimento += servico.custo_servico;
+            demandaRota += servico.demanda;
+            atual = parada.v;
+            visitas[idx]++;
+            if (diaValido) diasDoServico[idx] |= 1u << (rota.dia - 1);
+        }
+        long long regresso = deslocamento(atual, noDeposito);
+        if (regresso >= INF) verificacao.ligacoes_inalcancaveis++;
+        else custoRota += regresso;
+
+        verificacao.custo_recalculado += custoRota;
+        if (demandaRota > capacidadeVeiculo) verificacao.rotas_acima_capacidade++;
+        if (demandaRota != rota.demanda_total) verificacao.rotas_demanda_divergente++;
+        if (custoRota != rota.custo_total) verificacao.rotas_custo_divergente++;
+    }
+    verificacao.custo_total_consistente = somaCustosDeclarados == solucao.custo_total;
+
+    // Só as visitas em dias distintos contam para a frequência; as restantes são repetições.
+    for (int i = 0; i < numServicos; ++i) {
+        const Servico& servico = servicosRequeridos[i];
+        int diasDistintos = __builtin_popcount(diasDoServico[i]);
+        verificacao.servicos_repetidos += visitas[i] - diasDistintos + max(0, diasDistintos - servico.frequencia);
+        verificacao.servicos_em_falta += max(0, servico.frequencia - diasDistintos);
+        if (numDias > 1 && diasDistintos == servico.frequencia && !servico.combinacoes_dias.empty() &&
+            find(servico.combinacoes_dias.begin(), servico.combinacoes_dias.end(), diasDoServico[i]) == servico.combinacoes_dias.end()) {
+            verificacao.dias_invalidos++;
+        }
+    }
+    return verificacao;
 }
@@ -3,13 +3,26 @@
 
 #include <vector>
 #include <string>
-#include <set>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <chrono>
+#include <iosfwd>
+#include "Memoria.h"
+#include "HierarquiaContracao.h"
 
 using namespace std;
 
+const int INF = 1e9; // Representação de um valor muito elevado para simular o infinito em custos.
+
 // Declaração da função para limpar espaços de uma string.
 string limparEspacosGlobal(const string& s);
 
+// Lê os nomes base das instâncias a partir de um arquivo CSV de referência.
+vector<string> lerNomesBaseInstanciasDoCSV(const string& caminhoCSV);
+
 // Representa um serviço que precisa ser atendido, podendo ser um nó, aresta ou arco.
 struct Servico {
     string id_original;
@@ -19,7 +32,11 @@ struct Servico {
     int demanda;
     int custo_percurso;
     int custo_servico;
-    bool atendido = false;
+    int tempo_servico = 0;     // Duração do atendimento, medida nas mesmas unidades do custo.
+    int inicio_janela = 0;     // Instante mais cedo em que o atendimento pode começar.
+    int fim_janela = INF;      // Instante mais tarde em que o atendimento pode começar.
+    int frequencia = 1;        // Número de dias do horizonte em que o serviço deve ser atendido (modo periódico).
+    vector<unsigned int> combinacoes_dias; // Combinações de dias permitidas; o bit d-1 representa o dia d.
 };
 
 // Representa uma parada individual dentro da rota de um veículo.
@@ -28,39 +45,355 @@ struct ParadaRota {
     string id_servico;
     int u;
     int v;
+    int idx_servico; // Índice em servicosRequeridos, ou -1 para as paragens no depósito.
 };
 
 // Representa a rota completa de um veículo, incluindo todos os seus custos e paradas.
 struct Rota {
     int id_rota;
+    int dia = 1;           // Dia do horizonte de planeamento em que a rota é executada.
     int demanda_total = 0;
     int custo_total = 0;
+    int duracao = 0;       // Duração total da rota, incluindo deslocamentos, esperas e atendimentos.
+    int atraso_tempo = 0;  // Violação acumulada das janelas de tempo (time warp); zero numa rota viável.
     vector<ParadaRota> paradas;
 };
 
+// Dados agregados de uma subsequência de paragens, segundo a concatenação de segmentos de Vidal.
+// Juntar dois segmentos custa O(1), o que permite avaliar capacidade, duração e janelas de tempo
+// de uma rota modificada sem a percorrer novamente.
+struct SegmentoRota {
+    int noInicio = 0;
+    int noFim = 0;
+    long long custo = 0;
+    long long demanda = 0;
+    long long duracao = 0;
+    long long atraso = 0;              // Time warp acumulado no segmento.
+    long long inicioMaisCedo = 0;      // Instante mais cedo para iniciar o segmento sem espera evitável.
+    long long inicioMaisTarde = INF;   // Instante mais tarde para iniciar o segmento sem atraso adicional.
+};
+
+// Ligação lida do ficheiro (aresta ou arco, requerido ou não), guardada pela ordem de leitura.
+struct Ligacao {
+    int u, v;
+    int custo;
+    char codigo;    // Mesmo código de matrizAdj: 1 para arco, 2 para aresta.
+    bool requerida;
+};
+
+// Representação escolhida pelo construtor em função do limite de memória.
+enum RepresentacaoGrafo {
+    REPR_DENSA,          // Matrizes densas de adjacência, custos, distâncias e predecessores.
+    REPR_DENSA_SEM_PRED, // Como a densa, mas sem a matriz de predecessores (intermediação indisponível).
+    REPR_EXTREMOS,       // Sem matrizes densas: distâncias apenas entre o depósito e os extremos dos serviços.
+    REPR_HIERARQUIA      // Nem a tabela entre extremos cabe: distâncias pedidas a uma hierarquia de contração.
+};
+
+// Matriz densa guardada num único bloco contíguo, linha a linha, cujos bytes são contabilizados na categoria indicada.
+// O tipo da célula é o mais estreito que a instância permite (ver Grafo::escolherRepresentacao).
+template <class T, int Categoria>
+class MatrizPlana {
+public:
+    MatrizPlana() : colunas(0) {}
+
+    // Redimensiona a matriz e preenche todas as células com `valor`.
+    void redimensionar(size_t numLinhas, size_t numColunas, T valor) {
+        celulas.assign(numLinhas * numColunas, valor);
+        colunas = numColunas;
+    }
+    // Liberta a memória da matriz (clear() manteria a capacidade reservada).
+    void libertar() {
+        vector<T, AlocadorContador<T, Categoria>>().swap(celulas);
+        colunas = 0;
+    }
+    bool vazia() const { return celulas.empty(); }
+    size_t bytes() const { return celulas.capacity() * sizeof(T); }
+
+    T* linha(size_t i) { return celulas.data() + i * colunas; }
+    const T* linha(size_t i) const { return celulas.data() + i * colunas; }
+    T& operator()(size_t i, size_t j) { return celulas[i * colunas + j]; }
+    T operator()(size_t i, size_t j) const { return celulas[i * colunas + j]; }
+
+private:
+    vector<T, AlocadorContador<T, Categoria>> celulas;
+    size_t colunas;
+};
+
+// Conjunto de vértices 1..n guardado como bitset: um bit por vértice, pertença e inserção em O(1).
+template <int Categoria>
+class ConjuntoVertices {
+public:
+    ConjuntoVertices() : total(0) {}
+
+    // Prepara o conjunto para vértices de 0 a `maiorVertice`, esvaziando-o.
+    void redimensionar(int maiorVertice) {
+        palavras.assign(maiorVertice / 64 + 1, 0);
+        total = 0;
+    }
+    // Insere `v` e devolve true se ainda não pertencia ao conjunto.
+    bool inserir(int v) {
+        uint64_t bit = uint64_t(1) << (v % 64);
+        uint64_t& palavra = palavras[v / 64];
+        if (palavra & bit) return false;
+        palavra |= bit;
+        total++;
+        return true;
+    }
+    bool contem(int v) const {
+        return v >= 0 && static_cast<size_t>(v / 64) < palavras.size() && ((palavras[v / 64] >> (v % 64)) & 1);
+    }
+    size_t tamanho() const { return total; }
+    size_t bytes() const { return palavras.capacity() * sizeof(uint64_t); }
+
+    // Chama f(v) para cada vértice do conjunto, por ordem crescente.
+    template <class Funcao>
+    void paraCada(Funcao f) const {
+        for (size_t p = 0; p < palavras.size(); ++p) {
+            for (uint64_t resto = palavras[p]; resto != 0; resto &= resto - 1) {
+                f(static_cast<int>(p * 64 + __builtin_ctzll(resto)));
+            }
+        }
+    }
+
+private:
+    vector<uint64_t, AlocadorContador<uint64_t, Categoria>> palavras;
+    size_t total;
+};
+
+// Conjunto de pares ordenados (u, v) com endereçamento aberto e sondagem linear sobre chaves de 64 bits
+// (u nos 32 bits altos, v nos baixos). As chaves ficam num único vetor, sem um nó alocado por inserção;
+// depois de reservar() com o número esperado de pares, inserir não volta a alocar.
+template <int Categoria>
+class ConjuntoPares {
+public:
+    ConjuntoPares() : total(0), mascara(0) {}
+
+    // Dimensiona a tabela para `esperados` pares com fator de carga de no máximo 1/2.
+    void reservar(size_t esperados) {
+        size_t capacidade = 16;
+        while (capacidade < 2 * esperados) capacidade *= 2;
+        if (capacidade <= chaves.size()) return;
+        vector<uint64_t, AlocadorContador<uint64_t, Categoria>> antigas(capacidade, posicaoVazia());
+        antigas.swap(chaves);
+        mascara = capacidade - 1;
+        for (uint64_t chave : antigas) {
+            if (chave != posicaoVazia()) chaves[posicaoLivre(chave)] = chave;
+        }
+    }
+    // Insere o par e devolve true se ainda não pertencia ao conjunto. Se o cabeçalho da instância subestimar
+    // o número de pares, a tabela duplica quando passa de metade da ocupação.
+    bool inserir(int u, int v) {
+        if (2 * (total + 1) > chaves.size()) reservar(total + 1);
+        uint64_t chave = empacotar(u, v);
+        size_t i = posicaoLivre(chave);
+        if (chaves[i] == chave) return false;
+        chaves[i] = chave;
+        total++;
+        return true;
+    }
+    bool contem(int u, int v) const {
+        if (chaves.empty()) return false;
+        uint64_t chave = empacotar(u, v);
+        return chaves[posicaoLivre(chave)] == chave;
+    }
+    size_t tamanho() const { return total; }
+    size_t bytes() const { return chaves.capacity() * sizeof(uint64_t); }
+
+private:
+    static uint64_t posicaoVazia() { return ~uint64_t(0); } // Marca de posição livre (nenhum par tem u = v = -1).
+
+    static uint64_t empacotar(int u, int v) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(u)) << 32) | static_cast<uint32_t>(v);
+    }
+    // Posição da chave, ou da primeira posição vazia da sua sequência de sondagem.
+    size_t posicaoLivre(uint64_t chave) const {
+        size_t i = static_cast<size_t>((chave * 0x9E3779B97F4A7C15ull) >> 32) & mascara;
+        while (chaves[i] != posicaoVazia() && chaves[i] != chave) i = (i + 1) & mascara;
+        return i;
+    }
+
+    vector<uint64_t, AlocadorContador<uint64_t, Categoria>> chaves;
+    size_t total;
+    size_t mascara;
+};
+
+// Distâncias guardadas num inteiro sem sinal T: o maior valor representável faz de infinito. Como a soma é feita
+// num tipo mais largo e comparada com o valor guardado, um infinito nunca melhora um caminho e o min-plus do
+// Floyd-Warshall dispensa os testes explícitos de INF.
+template <class T>
+struct DistanciaSaturada {
+    typedef typename conditional<sizeof(T) < sizeof(uint32_t), uint32_t, uint64_t>::type Soma;
+
+    static T infinito() { return numeric_limits<T>::max(); }
+    // Conversão para a escala do solver, em que INF representa um vértice inalcançável.
+    static int paraInt(T d) {
+        if (d == infinito() || static_cast<uint64_t>(d) >= static_cast<uint64_t>(INF)) return INF;
+        return static_cast<int>(d);
+    }
+};
+
+// Resultado de uma execução do solver, antes da escrita em ficheiro.
+struct Solucao {
+    vector<Rota> rotas;
+    long long custo_total = 0;
+    long long penalidade_tempo = 0;
+    unsigned long long ciclos = 0;
+    // Ciclos gastos em cada fase do solver.
+    unsigned long long ciclos_caminhos = 0;
+    unsigned long long ciclos_construcao = 0;
+    unsigned long long ciclos_2opt = 0;
+    // Pico de memória residente (KB) durante cada fase.
+    long long memoria_caminhos_kb = 0;
+    long long memoria_construcao_kb = 0;
+    long long memoria_2opt_kb = 0;
+};
+
+// Saída opcional com as rotas expandidas: todos os vértices percorridos, incluindo os deslocamentos entre paragens.
+enum FormatoRotasExpandidas {
+    ROTAS_EXPANDIDAS_NENHUMA,
+    ROTAS_EXPANDIDAS_TEXTO,  // rotas-<instancia>.txt: uma linha "dia id_rota v0 v1 v2 ..." por rota.
+    ROTAS_EXPANDIDAS_BINARIO // rotas-<instancia>.bin: diferenças entre vértices consecutivos em varint zigzag.
+};
+
+// Espaço de trabalho da reconstrução de caminhos (definido em Grafo.cpp).
+struct EspacoExpansao;
+
+// Violações encontradas por Grafo::verificarSolucao numa solução lida de um ficheiro sol-*.dat.
+struct VerificacaoSolucao {
+    long long custo_recalculado = 0;    // Soma dos custos das rotas recalculados a partir da rede e dos serviços.
+    long long custo_atendimento = 0;    // Soma dos custos de atendimento (S. COST) das visitas feitas.
+    int servicos_em_falta = 0;          // Visitas exigidas (frequência de cada serviço) que nenhuma rota faz.
+    int servicos_repetidos = 0;         // Visitas além da frequência do serviço ou repetidas no mesmo dia.
+    int paragens_invalidas = 0;         // Serviço inexistente, extremidades trocadas ou depósito fora das pontas da rota.
+    int ligacoes_inalcancaveis = 0;     // Deslocamentos entre paragens sem caminho na rede.
+    int rotas_acima_capacidade = 0;
+    int rotas_demanda_divergente = 0;   // Demanda declarada diferente da soma das demandas atendidas.
+    int rotas_custo_divergente = 0;     // Custo declarado diferente do recalculado.
+    int dias_invalidos = 0;             // Rotas fora do horizonte ou serviços numa combinação de dias não permitida.
+    bool custo_total_consistente = true; // O custo total do cabeçalho é a soma dos custos declarados das rotas.
+
+    int totalViolacoes() const {
+        return servicos_em_falta + servicos_repetidos + paragens_invalidas + ligacoes_inalcancaveis + rotas_acima_capacidade +
+               rotas_demanda_divergente + rotas_custo_divergente + dias_invalidos + (custo_total_consistente ? 0 : 1);
+    }
+};
+
+// Distâncias de um grupo da decomposição: linhas para o depósito e os fins dos serviços do grupo, colunas para o
+// depósito e os inícios, que são os únicos pares consultados ao construir e otimizar as rotas do grupo.
+struct TabelaDistanciasGrupo {
+    vector<int> linhaDoVertice, colunaDoVertice; // -1 para os vértices que não são extremos do grupo.
+    vector<int> valores;                         // Linha a linha, na escala do solver (INF sem caminho).
+    size_t colunas = 0;
+};
+
 // Classe principal que encapsula todos os dados e a lógica do problema do carteiro rural.
 class Grafo {
 private:
     int numVertices;
-    vector<vector<int>> matrizAdj;
-    set<int> verticesRequeridos;
-    set<pair<int, int>> arestasRequeridasOriginal;
-    set<pair<int, int>> arcosRequeridosOriginal;
+    MatrizPlana<uint8_t, MEM_MATRIZ_ADJ> matrizAdj; // Códigos 0 a 3; vazia sem matrizes densas.
+    ConjuntoVertices<MEM_REQUERIDOS> verticesRequeridos;
+    ConjuntoPares<MEM_REQUERIDOS> arestasRequeridasOriginal; // Pares (min(u,v), max(u,v)).
+    ConjuntoPares<MEM_REQUERIDOS> arcosRequeridosOriginal;
+    vector<Ligacao, AlocadorContador<Ligacao, MEM_LIGACOES>> ligacoes;
+
+    // Só uma das matrizes de distâncias é preenchida: dist16 quando o maior caminho possível cabe em 16 bits.
+    // Em REPR_EXTREMOS, é indexada pela posição de cada vértice em indiceExtremo (-1 para os restantes).
+    MatrizPlana<uint16_t, MEM_DIST> dist16;
+    MatrizPlana<uint32_t, MEM_DIST> dist32;
+    bool distancias16;
+    MatrizPlana<uint16_t, MEM_PRED> pred; // SEM_PREDECESSOR quando não há caminho.
+    vector<int, AlocadorContador<int, MEM_DIST>> indiceExtremo;
+    HierarquiaContracao hierarquia; // Só construída em REPR_HIERARQUIA.
+    // Tabela do grupo que a thread está a resolver em resolverDecomposto (nula fora dele).
+    static thread_local const TabelaDistanciasGrupo* tabelaGrupo;
+    string caminhoHierarquia;       // Ficheiro onde a hierarquia da rede é guardada entre execuções.
 
-    vector<vector<int>> dist;
-    vector<vector<int>> pred;
+    long long limiteMemoriaBytes; // 0: sem limite explícito (orçamento por omissão, ver escolherRepresentacao).
+    RepresentacaoGrafo representacao;
+    bool distanciasCalculadas; // Indica se calcularCaminhosMinimosComCustos já preencheu as distâncias.
 
     int capacidadeVeiculo;
     int noDeposito;
-    vector<vector<int>> custosDiretos;
+    int duracaoMaximaRota; // Limite de turno por rota; 0 indica ausência de limite.
+    bool possuiJanelasTempo;
+    int numDias; // Dias do horizonte de planeamento; acima de 1 ativa o modo periódico.
+    FormatoRotasExpandidas formatoRotasExpandidas; // Escrito por construirESalvarSolucaoVM além do sol-*.dat.
     vector<Servico> servicosRequeridos;
 
-    // Aplica a heurística de otimização 2-opt para tentar melhorar as rotas existentes.
-    void aplicar2Opt(vector<Rota>& todasAsRotas);
+    // Escolhe, depois da leitura, a largura das distâncias e a representação que cabe no limite de memória,
+    // e preenche matrizAdj nas representações densas.
+    void escolherRepresentacao();
+    // Floyd-Warshall sobre a matriz de distâncias com células do tipo T.
+    template <class T>
+    void floydWarshall(MatrizPlana<T, MEM_DIST>& dist, bool comPred);
+    // Calcula, com Dijkstra a partir de cada extremo, as distâncias entre o depósito e os extremos dos serviços.
+    void calcularDistanciasEntreExtremos();
+    // Lista de adjacência compacta (CSR) da rede, com as arestas nos dois sentidos; `invertida` troca o sentido dos arcos.
+    void listaAdjacencia(vector<int>& inicio, vector<int>& destino, vector<int>& custo, bool invertida = false) const;
+    // Divide os serviços em grupos contíguos na ordem de uma varredura em profundidade da árvore de caminhos
+    // mínimos a partir do depósito, de forma que cada grupo ocupe um "setor" da rede.
+    vector<vector<int>> particionarServicos(int numGrupos) const;
+    // Calcula a tabela de distâncias reduzida do grupo de serviços indicado (índices em servicosRequeridos).
+    void prepararTabelaGrupo(const vector<int>& indices, TabelaDistanciasGrupo& tabela) const;
+    // Junta rotas pouco carregadas de grupos vizinhos na varredura e otimiza as rotas resultantes com 2-opt.
+    void repararFronteiras(vector<vector<Rota>>& rotasPorGrupo, int numThreads) const;
+    // Carrega a hierarquia de contração do ficheiro da rede ou, se não existir ou for de outra rede, constrói-a e grava-a.
+    void prepararHierarquia();
+    // Assinatura (FNV-1a) do número de vértices e das ligações, que identifica a rede de uma hierarquia gravada.
+    uint64_t assinaturaRede() const;
+    // Indica se as matrizes densas (adjacência e distâncias entre todos os pares) estão disponíveis.
+    bool matrizesDensas() const { return representacao == REPR_DENSA || representacao == REPR_DENSA_SEM_PRED; }
+    // Reconstrói os códigos de adjacência (par ordenado -> código de matrizAdj) a partir da lista de ligações,
+    // para as estatísticas na representação sem matrizes densas.
+    unordered_map<long long, char> codigosAdjacencia() const;
+    // Grau (número de vizinhos distintos, incluindo o próprio vértice se requerido) de cada vértice.
+    vector<int> calcularGraus();
+
+    // Aplica a heurística de otimização 2-opt para tentar melhorar as rotas existentes, em até `numThreads` threads
+    // (0 usa os núcleos disponíveis; 1 quando já é chamada dentro de uma thread de trabalho).
+    // Se for indicado um prazo, as passagens param quando ele é atingido (as rotas mantêm-se válidas).
+    void aplicar2Opt(vector<Rota>& todasAsRotas, chrono::steady_clock::time_point prazo = chrono::steady_clock::time_point::max(),
+                     int numThreads = 0) const;
+    // 2-opt de uma rota com restrições de tempo: melhor movimento por passagem, avaliado com segmentos de Vidal.
+    // Devolve false se o prazo foi atingido.
+    bool aplicar2OptMelhorMovimento(Rota& rota, vector<SegmentoRota>& unitario, vector<SegmentoRota>& prefixo, vector<SegmentoRota>& sufixo,
+                                    chrono::steady_clock::time_point prazo) const;
+    // 2-opt e or-opt de uma rota sem restrições de tempo: primeira melhoria com listas de vizinhos e marcas "don't look".
+    // Devolve false se o prazo foi atingido.
+    bool aplicar2OptVizinhos(Rota& rota, chrono::steady_clock::time_point prazo) const;
 
-    // Encontra o próximo serviço mais próximo e viável a partir da localização atual.
-    int encontrarServicoMaisProximo(int localizacaoAtual, int capacidadeAtual);
+    // Constrói rotas com o Vizinho Mais Próximo para o subconjunto de serviços indicado (índices em servicosRequeridos).
+    vector<Rota> construirRotas(const vector<int>& indices) const;
+
+    // Encontra, no subconjunto, o próximo serviço mais próximo e viável a partir da localização atual.
+    // Com restrições de tempo ativas, a viabilidade é testada em O(1) sobre o segmento já construído.
+    int encontrarServicoMaisProximo(const vector<int>& indices, const vector<char>& atendido, int localizacaoAtual, int capacidadeAtual,
+                                    const SegmentoRota& prefixo, bool respeitarTempo) const;
+
+    // Indica se a instância impõe limites de duração ou janelas de tempo.
+    bool restricoesTempoAtivas() const;
+    // Constrói o segmento unitário correspondente a uma paragem.
+    SegmentoRota segmentoDaParada(const ParadaRota& parada) const;
+    // Concatena dois segmentos, incluindo o deslocamento mínimo entre o fim do primeiro e o início do segundo.
+    SegmentoRota concatenarSegmentos(const SegmentoRota& a, const SegmentoRota& b) const;
+    // Penalidade de tempo de uma rota completa: time warp mais o excesso sobre a duração máxima.
+    long long penalidadeTempo(const SegmentoRota& rotaCompleta) const;
+    // Recalcula a duração e o atraso de uma rota a partir das suas paragens.
+    void avaliarTempoRota(Rota& rota) const;
+    // Escolhe uma combinação de dias para cada serviço, estimando o custo de inserção e a carga de cada dia.
+    vector<unsigned int> atribuirDias() const;
+    // Troca combinações de dias de serviços quando a remoção e a reinserção nas rotas já construídas reduzem o custo.
+    void refinarAtribuicaoDias(vector<unsigned int>& escolha, vector<vector<Rota>>& rotasPorDia) const;
+    // Preenche os segmentos unitários, os prefixos e os sufixos de uma rota.
+    void calcularSegmentos(const Rota& rota, vector<SegmentoRota>& unitario, vector<SegmentoRota>& prefixo, vector<SegmentoRota>& sufixo) const;
     
+    // Acrescenta a espaco.caminho os vértices de um caminho mínimo de `origem` a `destino`, do destino para trás
+    // e sem a origem: pela matriz de predecessores ou, sem ela, pela árvore de Dijkstra a partir da origem.
+    void caminhoInvertido(int origem, int destino, EspacoExpansao& espaco) const;
+    // Chama emitir(v) para cada vértice percorrido pela rota, pela ordem do percurso.
+    template <class Emitir>
+    void expandirRota(const Rota& rota, EspacoExpansao& espaco, Emitir emitir) const;
+
     // Lê o valor de clock de referência de um arquivo CSV para comparação de performance.
     long long lerClockRefDoCSV(const string& nomeInstanciaBase, int indiceColuna);
 
@@ -69,7 +402,34 @@ private:
 
 public:
     // Construtor da classe, responsável por ler e interpretar o arquivo da instância.
-    Grafo(const string& nomeArquivo);
+    // Com um limite de memória (em bytes), escolhe uma representação mais económica em vez de esgotar a memória.
+    Grafo(const string& nomeArquivo, long long limiteMemoriaBytes = 0);
+
+    // Distância mínima entre dois vértices. Em REPR_EXTREMOS só está definida para o depósito e os extremos dos serviços.
+    int distancia(int a, int b) const {
+        if (tabelaGrupo != nullptr) {
+            int linha = tabelaGrupo->linhaDoVertice[a], coluna = tabelaGrupo->colunaDoVertice[b];
+            if (linha >= 0 && coluna >= 0) return tabelaGrupo->valores[linha * tabelaGrupo->colunas + coluna];
+        }
+        if (representacao == REPR_HIERARQUIA) {
+            int d = hierarquia.distancia(a, b);
+            return d >= HierarquiaContracao::INF_HIERARQUIA ? INF : d;
+        }
+        if (!indiceExtremo.empty()) {
+            a = indiceExtremo[a];
+            b = indiceExtremo[b];
+        }
+        if (distancias16) return DistanciaSaturada<uint16_t>::paraInt(dist16(a, b));
+        return DistanciaSaturada<uint32_t>::paraInt(dist32(a, b));
+    }
+    // Indica se a ligação de u para v é requerida: um arco requerido (u, v) ou uma aresta requerida {u, v}.
+    bool ehLigacaoRequerida(int u, int v) const {
+        return arcosRequeridosOriginal.contem(u, v) || arestasRequeridasOriginal.contem(min(u, v), max(u, v));
+    }
+    // Representação escolhida para a instância.
+    RepresentacaoGrafo representacaoEscolhida() const;
+    // Nome da representação, usado nos relatórios.
+    string nomeRepresentacao() const;
 
     // Salva as estatísticas básicas do grafo em um arquivo CSV.
     void salvarEstatisticas();
@@ -94,6 +454,56 @@ public:
     // Calcula o grau máximo entre todos os vértices do grafo.
     int calcularGrauMaximo();
 
+    // Define o limite de duração de cada rota (turno da equipa); 0 remove o limite.
+    void definirDuracaoMaximaRota(int duracao);
+    // Define a janela de tempo e a duração do atendimento de um serviço (índice em servicosRequeridos).
+    void definirJanelaTempo(int idxServico, int inicio, int fim, int duracaoAtendimento);
+    // Número de serviços requeridos lidos da instância.
+    int numeroServicos() const;
+    // Duração do atendimento de um serviço (índice em servicosRequeridos).
+    int tempoServico(int idxServico) const;
+    // Índice em servicosRequeridos do serviço com o id original indicado (ex.: "E3"), ou -1 se não existir.
+    int indiceServico(const string& idOriginal) const;
+    // Demanda atual de um serviço (índice em servicosRequeridos).
+    int demandaServico(int idxServico) const;
+    // Altera a demanda de um serviço; lança exceção se o índice for inválido ou a demanda exceder a capacidade.
+    void definirDemanda(int idxServico, int demanda);
+    // Estimativa dos bytes ocupados pelas estruturas da instância (matrizes, conjuntos, ligações e serviços).
+    long long memoriaEstimadaBytes() const;
+
+    // Executa a heurística construtiva e a busca local, devolvendo a solução sem a gravar.
+    Solucao resolver();
+    // Como resolver(), mas reutiliza as distâncias já calculadas (só as calcula na primeira chamada) e interrompe
+    // o 2-opt ao fim de `orcamentoSegundos` (0 = sem limite), com no máximo `numThreads` threads (0 usa os núcleos
+    // disponíveis). Não mede a memória, que é partilhada pelo processo, pelo que serve para pedidos repetidos sobre
+    // o mesmo grafo, como no servidor.
+    Solucao resolverComOrcamento(double orcamentoSegundos, int numThreads = 0);
+    // Decomposição para instâncias muito grandes: particiona os serviços em `numGrupos` grupos, resolve cada grupo
+    // numa thread (no máximo `numThreads` em simultâneo; 0 usa os núcleos disponíveis) e junta as rotas com uma
+    // reparação das fronteiras entre grupos. Em REPR_HIERARQUIA cada grupo usa uma tabela de distâncias reduzida.
+    Solucao resolverDecomposto(int numGrupos, int numThreads = 0);
+    // Número de grupos usado por omissão: um por núcleo, com no máximo MAX_SERVICOS_GRUPO serviços por grupo.
+    int numeroGruposDecomposicao() const;
+    // Modo periódico: atribui dias aos serviços e resolve cada dia numa thread, partilhando a matriz de distâncias.
+    Solucao resolverPeriodico();
+    // Número de dias do horizonte de planeamento da instância.
+    int numeroDias() const;
+    // Grava a solução no formato especificado para a instância indicada.
+    void salvarSolucao(const Solucao& solucao, const string& nomeInstancia, const string& pastaDeSaida);
+    // Escreve uma linha por rota, no formato dos ficheiros de solução.
+    void escreverRotas(ostream& saida, const Solucao& solucao) const;
+    // Grava as rotas expandidas em `pastaDeSaida`, no formato indicado. Os vértices são escritos à medida que cada
+    // caminho é reconstruído, sem guardar a rota expandida em memória.
+    void salvarRotasExpandidas(const Solucao& solucao, const string& nomeInstancia, const string& pastaDeSaida, FormatoRotasExpandidas formato) const;
+    // Pede a construirESalvarSolucaoVM que grave também as rotas expandidas.
+    void definirRotasExpandidas(FormatoRotasExpandidas formato);
+    // Confere uma solução gravada contra a instância: cada serviço atendido tantas vezes quanto a sua frequência,
+    // paragens com as extremidades do serviço, capacidade, demandas e custos declarados. O custo de cada rota é
+    // recalculado como os deslocamentos mínimos entre paragens mais o percurso e o atendimento de cada serviço.
+    // As soluções de dados/padrao_solucoes e os valores de reference_values.csv não incluem o atendimento no custo;
+    // com `custoComAtendimento` = false, os custos declarados são conferidos nessa convenção.
+    VerificacaoSolucao verificarSolucao(const Solucao& solucao, bool custoComAtendimento = true) const;
+
     // Orquestra a criação da solução, desde a heurística construtiva até a otimização e salvamento.
     void construirESalvarSolucaoVM(const string& nomeInstancia, const string& pastaDeSaida);
 };
@@ -0,0 +1,412 @@
+#include "HierarquiaContracao.h"
+#include <fstream>
+#include <queue>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+const int HierarquiaContracao::INF_HIERARQUIA;
+
+const int LIMITE_TESTEMUNHA = 500;        // Vértices fixados por pesquisa de testemunha antes de desistir (e criar o atalho).
+const int BITS_MEMORIA_CONSULTAS = 16;    // 2^16 consultas recentes guardadas por thread.
+const char ASSINATURA_FICHEIRO[8] = {'M', 'C', 'G', 'R', 'P', 'C', 'H', '1'};
+
+typedef pair<int, int> EntradaFila; // (distância, vértice)
+typedef priority_queue<EntradaFila, vector<EntradaFila>, greater<EntradaFila>> FilaMinima;
+
+// Espaço de trabalho de uma pesquisa de Dijkstra: as distâncias ficam a INF e só os vértices alcançados
+// são repostos no fim, para não reinicializar o vetor inteiro a cada pesquisa.
+struct EspacoPesquisa {
+    vector<int> distancia;
+    vector<int> alcancados;
+    FilaMinima fila;
+
+    void preparar(int numVertices) {
+        if (static_cast<int>(distancia.size()) < numVertices + 1) distancia.assign(numVertices + 1, HierarquiaContracao::INF_HIERARQUIA);
+    }
+    void atualizar(int v, int d) {
+        if (distancia[v] == HierarquiaContracao::INF_HIERARQUIA) alcancados.push_back(v);
+        distancia[v] = d;
+        fila.push(EntradaFila(d, v));
+    }
+    void limpar() {
+        for (int v : alcancados) distancia[v] = HierarquiaContracao::INF_HIERARQUIA;
+        alcancados.clear();
+        fila = FilaMinima();
+    }
+};
+
+// Consulta recente, guardada numa tabela de mapeamento direto por thread.
+struct ConsultaMemorizada {
+    uint64_t par;
+    unsigned int dono; // Identificador da hierarquia; 0 indica uma posição vazia.
+    int distancia;
+};
+
+// Cada hierarquia construída ou carregada recebe um identificador novo, o que invalida as consultas memorizadas.
+static unsigned int novoIdentificador() {
+    static atomic<unsigned int> proximo(1);
+    return proximo++;
+}
+
+HierarquiaContracao::HierarquiaContracao() : numVertices(0), atalhos(0), identificador(novoIdentificador()), numAlvos(0) {}
+
+// Contração com ordem preguiçosa: a prioridade de um vértice é a diferença entre os atalhos que a sua contração
+// criaria e os arcos que remove, mais o número de vizinhos já contraídos (para espalhar a contração pelo grafo).
+// A prioridade do vértice no topo da fila é recalculada antes de o contrair; se piorou, volta para a fila.
+void HierarquiaContracao::construir(int n, const vector<ArcoEntrada>& arcos) {
+    numVertices = n;
+    atalhos = 0;
+    identificador = novoIdentificador();
+
+    // Grafo dinâmico: listas de saída e de entrada, sem arcos paralelos (fica o mais barato).
+    vector<vector<ArcoHierarquia>> saida(n + 1), entrada(n + 1);
+    auto inserirArco = [&](int u, int v, int custo) {
+        for (ArcoHierarquia& a : saida[u]) {
+            if (a.vizinho == v) {
+                if (custo < a.custo) {
+                    a.custo = custo;
+                    for (ArcoHierarquia& b : entrada[v]) if (b.vizinho == u) b.custo = custo;
+                }
+                return false;
+            }
+        }
+        saida[u].push_back({v, custo});
+        entrada[v].push_back({u, custo});
+        return true;
+    };
+    for (const ArcoEntrada& a : arcos) {
+        if (a.origem == a.destino || a.origem < 1 || a.destino < 1 || a.origem > n || a.destino > n) continue;
+        inserirArco(a.origem, a.destino, a.custo);
+    }
+
+    vector<char> contraido(n + 1, 0);
+    vector<int> vizinhosContraidos(n + 1, 0), profundidade(n + 1, 0);
+    EspacoPesquisa testemunha;
+    testemunha.preparar(n);
+
+    // Para cada entrada (u, v) e saída (v, x), chama atalho(u, x, custo) quando não há um caminho de u a x,
+    // sem passar por v, tão curto como u -> v -> x.
+    auto paraCadaAtalho = [&](int v, const function<void(int, int, int)>& atalho) {
+        int maiorSaida = 0;
+        for (const ArcoHierarquia& s : saida[v]) if (!contraido[s.vizinho]) maiorSaida = max(maiorSaida, s.custo);
+        for (const ArcoHierarquia& e : entrada[v]) {
+            int u = e.vizinho;
+            if (contraido[u]) continue;
+            long long limite = static_cast<long long>(e.custo) + maiorSaida;
+            testemunha.atualizar(u, 0);
+            int fixados = 0;
+            while (!testemunha.fila.empty() && fixados < LIMITE_TESTEMUNHA) {
+                EntradaFila atual = testemunha.fila.top();
+                testemunha.fila.pop();
+                if (atual.first > testemunha.distancia[atual.second]) continue;
+                if (atual.first > limite) break;
+                fixados++;
+                for (const ArcoHierarquia& a : saida[atual.second]) {
+                    if (contraido[a.vizinho] || a.vizinho == v) continue;
+                    int candidato = atual.first + a.custo;
+                    if (candidato < testemunha.distancia[a.vizinho]) testemunha.atualizar(a.vizinho, candidato);
+                }
+            }
+            for (const ArcoHierarquia& s : saida[v]) {
+                int x = s.vizinho;
+                if (contraido[x] || x == u) continue;
+                int viaV = e.custo + s.custo;
+                if (testemunha.distancia[x] > viaV) atalho(u, x, viaV);
+            }
+            testemunha.limpar();
+        }
+    };
+    auto prioridade = [&](int v) {
+        int atalhosNecessarios = 0, removidos = 0;
+        paraCadaAtalho(v, [&](int, int, int) { atalhosNecessarios++; });
+        for (const ArcoHierarquia& a : saida[v]) removidos += !contraido[a.vizinho];
+        for (const ArcoHierarquia& a : entrada[v]) removidos += !contraido[a.vizinho];
+        return 2 * (atalhosNecessarios - removidos) + vizinhosContraidos[v] + profundidade[v];
+    };
+
+    FilaMinima fila;
+    for (int v = 1; v <= n; ++v) fila.push(EntradaFila(prioridade(v), v));
+
+    // Os arcos de v para vértices ainda não contraídos (de nível superior) ficam definitivos no momento da contração.
+    vector<vector<ArcoHierarquia>> subidaPorVertice(n + 1), descidaPorVertice(n + 1);
+    while (!fila.empty()) {
+        int v = fila.top().second;
+        fila.pop();
+        if (contraido[v]) continue;
+        int atual = prioridade(v);
+        if (!fila.empty() && atual > fila.top().first) {
+            fila.push(EntradaFila(atual, v));
+            continue;
+        }
+
+        for (const ArcoHierarquia& a : saida[v]) if (!contraido[a.vizinho]) subidaPorVertice[v].push_back(a);
+        for (const ArcoHierarquia& a : entrada[v]) if (!contraido[a.vizinho]) descidaPorVertice[v].push_back(a);
+        paraCadaAtalho(v, [&](int u, int x, int custo) {
+            if (inserirArco(u, x, custo)) atalhos++;
+        });
+        contraido[v] = 1;
+        for (const ArcoHierarquia& a : saida[v]) {
+            vizinhosContraidos[a.vizinho]++;
+            profundidade[a.vizinho] = max(profundidade[a.vizinho], profundidade[v] + 1);
+        }
+        for (const ArcoHierarquia& a : entrada[v]) {
+            vizinhosContraidos[a.vizinho]++;
+            profundidade[a.vizinho] = max(profundidade[a.vizinho], profundidade[v] + 1);
+        }
+        // As listas do vértice contraído já não são precisas.
+        vector<ArcoHierarquia>().swap(saida[v]);
+        vector<ArcoHierarquia>().swap(entrada[v]);
+    }
+
+    auto compactar = [n](vector<vector<ArcoHierarquia>>& listas, VetorIndices& inicio, VetorArcos& destino) {
+        inicio.assign(n + 2, 0);
+        for (int v = 0; v <= n; ++v) inicio[v + 1] = inicio[v] + listas[v].size();
+        destino.clear();
+        destino.reserve(inicio[n + 1]);
+        for (int v = 0; v <= n; ++v) {
+            destino.insert(destino.end(), listas[v].begin(), listas[v].end());
+            vector<ArcoHierarquia>().swap(listas[v]);
+        }
+    };
+    compactar(subidaPorVertice, inicioSubida, subida);
+    compactar(descidaPorVertice, inicioDescida, descida);
+
+    alvoDoVertice.clear();
+    inicioBaldes.clear();
+    baldes.clear();
+    numAlvos = 0;
+}
+
+// Formato: assinatura do formato, assinatura da rede, n, número de atalhos, tamanhos dos dois grafos e os quatro vetores.
+bool HierarquiaContracao::salvar(const string& caminho, uint64_t assinaturaRede) const {
+    ofstream arquivo(caminho, ios::binary);
+    if (!arquivo.is_open()) return false;
+    uint64_t numAtalhos = atalhos, numSubida = subida.size(), numDescida = descida.size();
+    arquivo.write(ASSINATURA_FICHEIRO, sizeof(ASSINATURA_FICHEIRO));
+    arquivo.write(reinterpret_cast<const char*>(&assinaturaRede), sizeof(assinaturaRede));
+    arquivo.write(reinterpret_cast<const char*>(&numVertices), sizeof(numVertices));
+    arquivo.write(reinterpret_cast<const char*>(&numAtalhos), sizeof(numAtalhos));
+    arquivo.write(reinterpret_cast<const char*>(&numSubida), sizeof(numSubida));
+    arquivo.write(reinterpret_cast<const char*>(&numDescida), sizeof(numDescida));
+    arquivo.write(reinterpret_cast<const char*>(inicioSubida.data()), inicioSubida.size() * sizeof(int));
+    arquivo.write(reinterpret_cast<const char*>(subida.data()), subida.size() * sizeof(ArcoHierarquia));
+    arquivo.write(reinterpret_cast<const char*>(inicioDescida.data()), inicioDescida.size() * sizeof(int));
+    arquivo.write(reinterpret_cast<const char*>(descida.data()), descida.size() * sizeof(ArcoHierarquia));
+    return static_cast<bool>(arquivo);
+}
+
+bool HierarquiaContracao::carregar(const string& caminho, uint64_t assinaturaRede, int numVerticesRede) {
+    ifstream arquivo(caminho, ios::binary);
+    if (!arquivo.is_open()) return false;
+    char formato[sizeof(ASSINATURA_FICHEIRO)];
+    uint64_t assinatura = 0, numAtalhos = 0, numSubida = 0, numDescida = 0;
+    int n = 0;
+    arquivo.read(formato, sizeof(formato));
+    arquivo.read(reinterpret_cast<char*>(&assinatura), sizeof(assinatura));
+    arquivo.read(reinterpret_cast<char*>(&n), sizeof(n));
+    arquivo.read(reinterpret_cast<char*>(&numAtalhos), sizeof(numAtalhos));
+    arquivo.read(reinterpret_cast<char*>(&numSubida), sizeof(numSubida));
+    arquivo.read(reinterpret_cast<char*>(&numDescida), sizeof(numDescida));
+    if (!arquivo || memcmp(formato, ASSINATURA_FICHEIRO, sizeof(formato)) != 0 || assinatura != assinaturaRede ||
+        n <= 0 || n != numVerticesRede) {
+        return false;
+    }
+
+    // Os contadores vêm do ficheiro: têm de caber nos índices int e o resto do ficheiro tem de ter exatamente os
+    // bytes que eles anunciam, antes de qualquer redimensionamento.
+    const streamoff inicioDados = arquivo.tellg();
+    arquivo.seekg(0, ios::end);
+    const uint64_t restantes = static_cast<uint64_t>(arquivo.tellg() - inicioDados);
+    arquivo.seekg(inicioDados);
+    const uint64_t bytesInicios = 2 * (static_cast<uint64_t>(n) + 2) * sizeof(int);
+    const uint64_t maxArcos = static_cast<uint64_t>(numeric_limits<int>::max());
+    if (!arquivo || restantes < bytesInicios || numSubida > maxArcos || numDescida > maxArcos ||
+        restantes - bytesInicios != (numSubida + numDescida) * sizeof(ArcoHierarquia)) {
+        return false;
+    }
+
+    VetorIndices novoInicioSubida(n + 2), novoInicioDescida(n + 2);
+    VetorArcos novaSubida(numSubida), novaDescida(numDescida);
+    arquivo.read(reinterpret_cast<char*>(novoInicioSubida.data()), novoInicioSubida.size() * sizeof(int));
+    arquivo.read(reinterpret_cast<char*>(novaSubida.data()), novaSubida.size() * sizeof(ArcoHierarquia));
+    arquivo.read(reinterpret_cast<char*>(novoInicioDescida.data()), novoInicioDescida.size() * sizeof(int));
+    arquivo.read(reinterpret_cast<char*>(novaDescida.data()), novaDescida.size() * sizeof(ArcoHierarquia));
+    if (!arquivo || static_cast<uint64_t>(novoInicioSubida[n + 1]) != numSubida || static_cast<uint64_t>(novoInicioDescida[n + 1]) != numDescida) {
+        return false;
+    }
+    // Índices crescentes e vizinhos dentro da rede, para que as pesquisas nunca saiam dos vetores.
+    auto consistente = [n](const VetorIndices& inicio, const VetorArcos& arcos) {
+        if (inicio[0] != 0) return false;
+        for (int v = 0; v <= n; ++v) if (inicio[v] > inicio[v + 1]) return false;
+        for (const ArcoHierarquia& a : arcos) if (a.vizinho < 0 || a.vizinho > n || a.custo < 0) return false;
+        return true;
+    };
+    if (!consistente(novoInicioSubida, novaSubida) || !consistente(novoInicioDescida, novaDescida)) return false;
+
+    numVertices = n;
+    atalhos = numAtalhos;
+    identificador = novoIdentificador();
+    inicioSubida.swap(novoInicioSubida);
+    inicioDescida.swap(novoInicioDescida);
+    subida.swap(novaSubida);
+    descida.swap(novaDescida);
+    alvoDoVertice.clear();
+    inicioBaldes.clear();
+    baldes.clear();
+    numAlvos = 0;
+    return true;
+}
+
+// Um vértice v fixado com distância d está "parado" se algum vértice w de nível superior já alcançado tiver um arco
+// para v (no sentido da pesquisa) com distancia[w] + custo < d: o caminho mínimo até v desce de w e não pertence
+// a esta pesquisa para cima, pelo que v não é expandido nem contribui para encontros ou baldes.
+bool HierarquiaContracao::parado(const vector<int>& distancia, int v, int d, const VetorIndices& inicioContrarios, const VetorArcos& contrarios) const {
+    for (int k = inicioContrarios[v]; k < inicioContrarios[v + 1]; ++k) {
+        int dw = distancia[contrarios[k].vizinho];
+        if (dw != INF_HIERARQUIA && dw + contrarios[k].custo < d) return true;
+    }
+    return false;
+}
+
+template <class Visitar>
+void HierarquiaContracao::pesquisarSubida(int inicio, const VetorIndices& inicioArcos, const VetorArcos& arcos, const VetorIndices& inicioContrarios,
+                                          const VetorArcos& contrarios, Visitar visitar) const {
+    static thread_local EspacoPesquisa espaco;
+    espaco.preparar(numVertices);
+    espaco.atualizar(inicio, 0);
+    while (!espaco.fila.empty()) {
+        EntradaFila atual = espaco.fila.top();
+        espaco.fila.pop();
+        int v = atual.second;
+        if (atual.first > espaco.distancia[v]) continue;
+        if (parado(espaco.distancia, v, atual.first, inicioContrarios, contrarios)) continue;
+        visitar(v, atual.first);
+        for (int k = inicioArcos[v]; k < inicioArcos[v + 1]; ++k) {
+            int candidato = atual.first + arcos[k].custo;
+            if (candidato < espaco.distancia[arcos[k].vizinho]) espaco.atualizar(arcos[k].vizinho, candidato);
+        }
+    }
+    espaco.limpar();
+}
+
+// Pesquisa bidirecional alternada: a frente sobe a partir da origem, a de trás sobe a partir do destino pelos arcos
+// invertidos. Termina quando o menor elemento das duas filas já não pode melhorar o melhor encontro.
+int HierarquiaContracao::distancia(int origem, int destino) const {
+    if (origem == destino) return 0;
+    if (origem < 1 || destino < 1 || origem > numVertices || destino > numVertices) return INF_HIERARQUIA;
+
+    // O 2-opt e a verificação de tempo repetem muitas vezes os mesmos pares: as consultas recentes são memorizadas.
+    static thread_local vector<ConsultaMemorizada> memoria;
+    if (memoria.empty()) memoria.assign(size_t(1) << BITS_MEMORIA_CONSULTAS, ConsultaMemorizada{0, 0, 0});
+    uint64_t par = (static_cast<uint64_t>(origem) << 32) | static_cast<uint32_t>(destino);
+    ConsultaMemorizada& memorizada = memoria[(par * 0x9E3779B97F4A7C15ull) >> (64 - BITS_MEMORIA_CONSULTAS)];
+    if (memorizada.dono == identificador && memorizada.par == par) return memorizada.distancia;
+
+    static thread_local EspacoPesquisa frente, tras;
+    frente.preparar(numVertices);
+    tras.preparar(numVertices);
+    frente.atualizar(origem, 0);
+    tras.atualizar(destino, 0);
+    int melhor = INF_HIERARQUIA;
+    while (!frente.fila.empty() || !tras.fila.empty()) {
+        int topoFrente = frente.fila.empty() ? INF_HIERARQUIA : frente.fila.top().first;
+        int topoTras = tras.fila.empty() ? INF_HIERARQUIA : tras.fila.top().first;
+        if (min(topoFrente, topoTras) >= melhor) break;
+
+        bool avancarFrente = topoFrente <= topoTras;
+        EspacoPesquisa& lado = avancarFrente ? frente : tras;
+        const EspacoPesquisa& outro = avancarFrente ? tras : frente;
+        const VetorIndices& inicioArcos = avancarFrente ? inicioSubida : inicioDescida;
+        const VetorArcos& arcos = avancarFrente ? subida : descida;
+        const VetorIndices& inicioContrarios = avancarFrente ? inicioDescida : inicioSubida;
+        const VetorArcos& contrarios = avancarFrente ? descida : subida;
+
+        EntradaFila atual = lado.fila.top();
+        lado.fila.pop();
+        int v = atual.second;
+        if (atual.first > lado.distancia[v]) continue;
+        if (parado(lado.distancia, v, atual.first, inicioContrarios, contrarios)) continue;
+        if (outro.distancia[v] != INF_HIERARQUIA) melhor = min(melhor, atual.first + outro.distancia[v]);
+        for (int k = inicioArcos[v]; k < inicioArcos[v + 1]; ++k) {
+            int candidato = atual.first + arcos[k].custo;
+            if (candidato < lado.distancia[arcos[k].vizinho]) lado.atualizar(arcos[k].vizinho, candidato);
+        }
+    }
+    frente.limpar();
+    tras.limpar();
+
+    memorizada.par = par;
+    memorizada.dono = identificador;
+    memorizada.distancia = melhor;
+    return melhor;
+}
+
+// Cada alvo j deixa, em cada vértice da sua pesquisa para trás, a entrada (j, distância desse vértice até ao alvo).
+// Alvos fora de 1..n não deixam entradas e ficam a INF_HIERARQUIA.
+void HierarquiaContracao::construirBaldes(const vector<int>& alvos, VetorIndices& inicio, VetorArcos& entradasBaldes) const {
+    vector<pair<int, ArcoHierarquia>> entradas; // (vértice do balde, (alvo, distância))
+    for (size_t j = 0; j < alvos.size(); ++j) {
+        if (alvos[j] < 1 || alvos[j] > numVertices) continue;
+        int alvo = static_cast<int>(j);
+        pesquisarSubida(alvos[j], inicioDescida, descida, inicioSubida, subida, [&entradas, alvo](int v, int d) {
+            entradas.push_back(make_pair(v, ArcoHierarquia{alvo, d}));
+        });
+    }
+    inicio.assign(numVertices + 2, 0);
+    for (const auto& e : entradas) inicio[e.first + 1]++;
+    for (int v = 0; v <= numVertices; ++v) inicio[v + 1] += inicio[v];
+    entradasBaldes.assign(entradas.size(), ArcoHierarquia{0, 0});
+    vector<int> proximo(inicio.begin(), inicio.end() - 1);
+    for (const auto& e : entradas) entradasBaldes[proximo[e.first]++] = e.second;
+}
+
+// Pesquisa para a frente a partir de `origem`, combinando cada vértice fixado com as entradas do seu balde.
+void HierarquiaContracao::percorrerBaldes(int origem, const VetorIndices& inicio, const VetorArcos& entradasBaldes, int* distancias) const {
+    if (origem < 1 || origem > numVertices || inicio.empty()) return;
+    pesquisarSubida(origem, inicioSubida, subida, inicioDescida, descida, [&inicio, &entradasBaldes, distancias](int v, int d) {
+        for (int k = inicio[v]; k < inicio[v + 1]; ++k) {
+            int total = d + entradasBaldes[k].custo;
+            if (total < distancias[entradasBaldes[k].vizinho]) distancias[entradasBaldes[k].vizinho] = total;
+        }
+    });
+}
+
+void HierarquiaContracao::prepararAlvos(const vector<int>& alvos) {
+    alvoDoVertice.assign(numVertices + 1, -1);
+    numAlvos = 0;
+    vector<int> distintos;
+    for (int t : alvos) {
+        if (t >= 1 && t <= numVertices && alvoDoVertice[t] == -1) {
+            alvoDoVertice[t] = numAlvos++;
+            distintos.push_back(t);
+        }
+    }
+    construirBaldes(distintos, inicioBaldes, baldes);
+}
+
+void HierarquiaContracao::distanciasParaAlvos(int origem, vector<int>& distancias) const {
+    distancias.assign(numAlvos, INF_HIERARQUIA);
+    if (numAlvos > 0) percorrerBaldes(origem, inicioBaldes, baldes, distancias.data());
+}
+
+// Os baldes são locais à chamada, pelo que várias threads podem calcular tabelas ao mesmo tempo.
+void HierarquiaContracao::tabelaMuitosParaMuitos(const vector<int>& origens, const vector<int>& destinos, vector<int>& tabela) const {
+    tabela.assign(origens.size() * destinos.size(), INF_HIERARQUIA);
+    if (destinos.empty()) return;
+    VetorIndices inicio;
+    VetorArcos entradasBaldes;
+    construirBaldes(destinos, inicio, entradasBaldes);
+    for (size_t i = 0; i < origens.size(); ++i) {
+        percorrerBaldes(origens[i], inicio, entradasBaldes, tabela.data() + i * destinos.size());
+    }
+}
+
+long long HierarquiaContracao::bytes() const {
+    return (inicioSubida.capacity() + inicioDescida.capacity() + alvoDoVertice.capacity() + inicioBaldes.capacity()) * sizeof(int) +
+           (subida.capacity() + descida.capacity() + baldes.capacity()) * sizeof(ArcoHierarquia);
+}
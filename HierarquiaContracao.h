@@ -0,0 +1,95 @@
+#ifndef HIERARQUIA_CONTRACAO_H
+#define HIERARQUIA_CONTRACAO_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Memoria.h"
+
+using namespace std;
+
+// Arco dirigido de entrada da hierarquia: de `origem` para `destino`, com o custo indicado.
+struct ArcoEntrada {
+    int origem, destino;
+    int custo;
+};
+
+// Arco da hierarquia já construída, guardado no vértice de menor nível.
+struct ArcoHierarquia {
+    int vizinho;
+    int custo;
+};
+
+// Hierarquia de contração sobre um grafo dirigido com vértices 1..n.
+// Os vértices são contraídos por ordem de importância e, quando o caminho mínimo entre dois vizinhos passava
+// pelo vértice contraído, é acrescentado um atalho. Uma consulta s -> t é uma pesquisa bidirecional que só sobe
+// na hierarquia: para a frente a partir de s e para trás a partir de t, sem precisar de tabelas n x n.
+class HierarquiaContracao {
+public:
+    HierarquiaContracao();
+
+    // Constrói a hierarquia. Arestas de dois sentidos devem ser dadas como dois arcos.
+    void construir(int numVertices, const vector<ArcoEntrada>& arcos);
+    // Grava a hierarquia num ficheiro binário, junto com a assinatura da rede que a originou.
+    // Devolve false se o ficheiro não puder ser escrito.
+    bool salvar(const string& caminho, uint64_t assinaturaRede) const;
+    // Carrega a hierarquia se o ficheiro existir e tiver sido construído para a mesma rede (mesma assinatura e
+    // `numVerticesRede` vértices). Um ficheiro truncado ou inconsistente é rejeitado antes de qualquer alocação
+    // proporcional ao seu conteúdo, e a hierarquia é então reconstruída por quem chamou.
+    bool carregar(const string& caminho, uint64_t assinaturaRede, int numVerticesRede);
+
+    bool construida() const { return numVertices > 0; }
+    size_t numeroAtalhos() const { return atalhos; }
+
+    // Distância mínima de `origem` a `destino`, ou INF_HIERARQUIA se não houver caminho.
+    // Segura para várias threads: o espaço de trabalho e a memória das últimas consultas são locais a cada thread.
+    int distancia(int origem, int destino) const;
+
+    // Modo muitos-para-muitos: guarda, para cada alvo, a sua pesquisa para trás em baldes nos vértices visitados.
+    void prepararAlvos(const vector<int>& alvos);
+    // Posição do vértice na lista de alvos preparada, ou -1.
+    int indiceAlvo(int vertice) const { return vertice >= 0 && vertice < static_cast<int>(alvoDoVertice.size()) ? alvoDoVertice[vertice] : -1; }
+    // Distâncias de `origem` a todos os alvos preparados, com uma única pesquisa para a frente.
+    void distanciasParaAlvos(int origem, vector<int>& distancias) const;
+
+    // Tabela de distâncias origens x destinos, guardada linha a linha (INF_HIERARQUIA sem caminho), calculada com
+    // baldes próprios da chamada: não altera os alvos preparados e pode ser usada por várias threads ao mesmo tempo.
+    void tabelaMuitosParaMuitos(const vector<int>& origens, const vector<int>& destinos, vector<int>& tabela) const;
+
+    // Bytes ocupados pela hierarquia e pelos baldes.
+    long long bytes() const;
+
+    static const int INF_HIERARQUIA = 1000000000;
+
+private:
+    typedef vector<int, AlocadorContador<int, MEM_HIERARQUIA>> VetorIndices;
+    typedef vector<ArcoHierarquia, AlocadorContador<ArcoHierarquia, MEM_HIERARQUIA>> VetorArcos;
+
+    // Baldes dos alvos indicados (posição na lista, distância até ao alvo) em formato CSR, indexados por vértice.
+    void construirBaldes(const vector<int>& alvos, VetorIndices& inicio, VetorArcos& entradasBaldes) const;
+    // Minimiza distancias[j] com as entradas dos baldes encontradas na pesquisa para a frente a partir de `origem`.
+    void percorrerBaldes(int origem, const VetorIndices& inicio, const VetorArcos& entradasBaldes, int* distancias) const;
+    // Paragem a pedido: indica se v, fixado com distância d, é alcançado mais cedo descendo de um vértice superior.
+    bool parado(const vector<int>& distancia, int v, int d, const VetorIndices& inicioContrarios, const VetorArcos& contrarios) const;
+    // Pesquisa para cima a partir de `inicio` em (inicioArcos, arcos), chamando visitar(v, d) para cada vértice fixado
+    // e não parado; (inicioContrarios, contrarios) são os arcos do sentido oposto, usados na paragem a pedido.
+    template <class Visitar>
+    void pesquisarSubida(int inicio, const VetorIndices& inicioArcos, const VetorArcos& arcos, const VetorIndices& inicioContrarios,
+                         const VetorArcos& contrarios, Visitar visitar) const;
+
+    int numVertices;
+    size_t atalhos;
+    unsigned int identificador; // Distingue as instâncias na memória de consultas partilhada pela thread.
+
+    // Grafo de subida em formato CSR: arcos v -> w com nível(w) > nível(v), e arcos w -> v com nível(w) > nível(v)
+    // guardados em v (para a pesquisa para trás).
+    VetorIndices inicioSubida, inicioDescida;
+    VetorArcos subida, descida;
+
+    // Baldes do modo muitos-para-muitos, também em CSR: para cada vértice, (índice do alvo, distância até ao alvo).
+    VetorIndices alvoDoVertice, inicioBaldes;
+    VetorArcos baldes;
+    int numAlvos;
+};
+
+#endif // HIERARQUIA_CONTRACAO_H
@@ -0,0 +1,126 @@
+#ifndef MEMORIA_H
+#define MEMORIA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+
+using namespace std;
+
+// Lê um campo (em KB) de /proc/self/status. Devolve 0 em plataformas sem /proc.
+inline long long lerCampoStatusKB(const string& campo) {
+    ifstream status("/proc/self/status");
+    string linha;
+    while (getline(status, linha)) {
+        if (linha.compare(0, campo.size(), campo) == 0) {
+            return atoll(linha.c_str() + campo.size());
+        }
+    }
+    return 0;
+}
+
+// Memória física total da máquina, em bytes (campo MemTotal de /proc/meminfo). Devolve 0 em plataformas sem /proc.
+inline long long memoriaFisicaBytes() {
+    ifstream meminfo("/proc/meminfo");
+    string linha;
+    while (getline(meminfo, linha)) {
+        if (linha.compare(0, 9, "MemTotal:") == 0) return atoll(linha.c_str() + 9) * 1024LL;
+    }
+    return 0;
+}
+
+// Memória residente atual do processo, em KB.
+inline long long memoriaResidenteKB() {
+    return lerCampoStatusKB("VmRSS:");
+}
+
+// Pico de memória residente do processo desde o seu início (ou desde o último reinício), em KB.
+inline long long picoMemoriaResidenteKB() {
+    return lerCampoStatusKB("VmHWM:");
+}
+
+// Reinicia o pico de memória residente (Linux 4.0+), para que VmHWM passe a medir apenas a fase seguinte.
+// Devolve false se não for suportado; nesse caso o pico continua a ser o do processo inteiro.
+inline bool reiniciarPicoMemoriaResidente() {
+    ofstream clearRefs("/proc/self/clear_refs");
+    if (!clearRefs.is_open()) return false;
+    clearRefs << "5";
+    clearRefs.close();
+    return !clearRefs.fail();
+}
+
+// Categorias de estruturas cujo consumo de memória é contabilizado pelo AlocadorContador.
+enum CategoriaMemoria {
+    MEM_MATRIZ_ADJ,
+    MEM_DIST,
+    MEM_PRED,
+    MEM_REQUERIDOS,
+    MEM_LIGACOES,
+    MEM_HIERARQUIA,
+    NUM_CATEGORIAS_MEMORIA
+};
+
+// Nome de cada categoria, usado nos relatórios e no CSV do benchmark.
+inline const char* nomeCategoriaMemoria(int categoria) {
+    static const char* nomes[NUM_CATEGORIAS_MEMORIA] = {
+        "matriz_adj", "dist", "pred", "requeridos", "ligacoes", "hierarquia"
+    };
+    return nomes[categoria];
+}
+
+// Bytes atualmente alocados em cada categoria (soma de todas as instâncias de Grafo vivas no processo).
+inline atomic<long long>* bytesEmUsoPorCategoria() {
+    static atomic<long long> contadores[NUM_CATEGORIAS_MEMORIA] = {};
+    return contadores;
+}
+
+// Maior valor atingido por cada contador desde o último reiniciarPicosCategorias().
+inline atomic<long long>* picoBytesPorCategoria() {
+    static atomic<long long> picos[NUM_CATEGORIAS_MEMORIA] = {};
+    return picos;
+}
+
+// Faz o pico de cada categoria coincidir com o consumo atual.
+inline void reiniciarPicosCategorias() {
+    for (int c = 0; c < NUM_CATEGORIAS_MEMORIA; ++c) {
+        picoBytesPorCategoria()[c] = bytesEmUsoPorCategoria()[c].load();
+    }
+}
+
+// Alocador que contabiliza os bytes pedidos pelos contentores da categoria indicada.
+template <class T, int Categoria>
+struct AlocadorContador {
+    typedef T value_type;
+
+    template <class U>
+    struct rebind { typedef AlocadorContador<U, Categoria> other; };
+
+    AlocadorContador() {}
+    template <class U>
+    AlocadorContador(const AlocadorContador<U, Categoria>&) {}
+
+    T* allocate(size_t n) {
+        long long bytes = static_cast<long long>(n * sizeof(T));
+        T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+        long long emUso = (bytesEmUsoPorCategoria()[Categoria] += bytes);
+        atomic<long long>& pico = picoBytesPorCategoria()[Categoria];
+        long long anterior = pico.load();
+        while (emUso > anterior && !pico.compare_exchange_weak(anterior, emUso)) {}
+        return p;
+    }
+
+    void deallocate(T* p, size_t n) {
+        bytesEmUsoPorCategoria()[Categoria] -= static_cast<long long>(n * sizeof(T));
+        ::operator delete(p);
+    }
+};
+
+template <class T, class U, int C>
+bool operator==(const AlocadorContador<T, C>&, const AlocadorContador<U, C>&) { return true; }
+template <class T, class U, int C>
+bool operator!=(const AlocadorContador<T, C>&, const AlocadorContador<U, C>&) { return false; }
+
+#endif // MEMORIA_H
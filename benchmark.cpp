@@ -0,0 +1,279 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <x86intrin.h>
+#include "Grafo.h"
+#include "GeradorInstancias.h"
+#include "Memoria.h"
+
+#ifdef _WIN32
+#include <direct.h> // Para _mkdir no Windows
+#else
+#include <sys/stat.h> // Para mkdir em sistemas Unix/Linux
+#endif
+
+using namespace std;
+
+// Compara o solver sem restrições de tempo com o solver sujeito a janelas de tempo e limite de turno.
+// As restrições são sintéticas: o limite de turno é a maior duração de rota da solução sem restrições,
+// e cada serviço recebe uma janela aleatória (semente fixa) dentro desse horizonte, mantendo a sua duração de
+// atendimento. Os caminhos mínimos são calculados uma só vez, na primeira resolução, e não dependem das janelas;
+// a comparação é feita sobre a construção e o 2-opt.
+int executarBenchmarkTempo(size_t limiteInstancias) {
+    string caminhoArquivoReferencias = "dados/reference_values.csv";
+    string pastaDasInstancias = "dados/MCGRP/";
+    string caminhoSaida = "output/benchmark_tempo.csv";
+
+    vector<string> nomesDasInstancias = lerNomesBaseInstanciasDoCSV(caminhoArquivoReferencias);
+    if (limiteInstancias > 0 && limiteInstancias < nomesDasInstancias.size()) {
+        nomesDasInstancias.resize(limiteInstancias);
+    }
+
+    ofstream csv(caminhoSaida);
+    if (!csv.is_open()) {
+        cerr << "ERRO: Nao foi possivel criar '" << caminhoSaida << "'." << endl;
+        return 1;
+    }
+    csv << "instancia,ciclos_caminhos,ciclos_heuristica_livre,ciclos_heuristica_restrito,razao_heuristica,"
+        << "rotas_livre,rotas_restrito,custo_livre,custo_restrito,penalidade_restrito" << endl;
+
+    mt19937 gerador(42);
+    double somaLogRazao = 0.0, piorRazao = 0.0;
+    int medidas = 0;
+
+    for (const string& nome : nomesDasInstancias) {
+        try {
+            Grafo g(pastaDasInstancias + nome + ".dat");
+            if (g.numeroServicos() == 0) continue;
+
+            Solucao livre = g.resolver();
+
+            int horizonte = 0;
+            for (const auto& rota : livre.rotas) horizonte = max(horizonte, rota.duracao);
+            uniform_int_distribution<int> inicioJanela(0, max(1, horizonte * 7 / 10));
+            for (int i = 0; i < g.numeroServicos(); ++i) {
+                int inicio = inicioJanela(gerador);
+                g.definirJanelaTempo(i, inicio, inicio + horizonte / 2, g.tempoServico(i));
+            }
+            g.definirDuracaoMaximaRota(horizonte);
+
+            Solucao restrita = g.resolver();
+
+            unsigned long long heurLivre = livre.ciclos_construcao + livre.ciclos_2opt;
+            unsigned long long heurRestrita = restrita.ciclos_construcao + restrita.ciclos_2opt;
+            double razaoHeur = static_cast<double>(heurRestrita) / max(1ULL, heurLivre);
+
+            csv << nome << "," << livre.ciclos_caminhos << ","
+                << heurLivre << "," << heurRestrita << "," << razaoHeur << ","
+                << livre.rotas.size() << "," << restrita.rotas.size() << ","
+                << livre.custo_total << "," << restrita.custo_total << "," << restrita.penalidade_tempo << endl;
+
+            somaLogRazao += log(razaoHeur);
+            piorRazao = max(piorRazao, razaoHeur);
+            medidas++;
+        } catch (const std::exception& e) {
+            cerr << "ERRO ao processar instancia " << nome << ": " << e.what() << endl;
+        }
+    }
+    csv.close();
+
+    if (medidas > 0) {
+        double media = exp(somaLogRazao / medidas);
+        cout << "Instancias medidas: " << medidas << endl;
+        cout << "Razao media (geometrica) restrito/livre: " << media << endl;
+        cout << "Pior razao restrito/livre: " << piorRazao << endl;
+        cout << "Resultados em: " << caminhoSaida << endl;
+        return media <= 2.0 ? 0 : 2;
+    }
+    return 0;
+}
+
+// Campo de CSV entre aspas quando contém separadores, aspas ou quebras de linha.
+static string campoCSV(const string& texto) {
+    if (texto.find_first_of(",\"\r\n") == string::npos) return texto;
+    string campo = "\"";
+    for (char c : texto) {
+        if (c == '"') campo += '"';
+        campo += c;
+    }
+    return campo + "\"";
+}
+
+// Caminho da instância sintética do tipo e tamanho indicados em `pasta`, gerando-a se ainda não existir.
+string instanciaSintetica(const string& pasta, ParametrosGerador::Tipo tipo, int nos) {
+    string nomeTipo = (tipo == ParametrosGerador::GRADE) ? "grade" : "viario";
+    string nome = nomeTipo + "-n" + to_string(nos);
+    string caminho = pasta + "/" + nome + ".dat";
+
+    ifstream existente(caminho);
+    if (!existente.good()) {
+        ParametrosGerador parametros;
+        parametros.tipo = tipo;
+        parametros.numNos = nos;
+        gerarInstancia(parametros, nome, caminho);
+    }
+    return caminho;
+}
+
+// Varre instâncias sintéticas de tamanho crescente (grade e viária) e regista, por fase, os ciclos gastos,
+// o pico de memória residente e o pico de bytes de cada estrutura do Grafo. O limite de memória é passado ao Grafo,
+// que escolhe uma representação mais económica quando as matrizes densas não cabem; só os tamanhos que nem
+// assim cabem ficam registados como sem memória.
+int executarBenchmarkEscala(long long limiteMemoriaMB, const vector<int>& tamanhos) {
+    string pastaSinteticas = "output/instancias_sinteticas";
+    string caminhoSaida = "output/benchmark_escala.csv";
+
+    #ifdef _WIN32
+        _mkdir(pastaSinteticas.c_str());
+    #else
+        mkdir(pastaSinteticas.c_str(), 0777);
+    #endif
+
+    ofstream csv(caminhoSaida);
+    if (!csv.is_open()) {
+        cerr << "ERRO: Nao foi possivel criar '" << caminhoSaida << "'." << endl;
+        return 1;
+    }
+    csv << "tipo,nos,servicos,estado,representacao,ciclos_leitura,ciclos_caminhos,ciclos_construcao,ciclos_2opt,"
+        << "memoria_leitura_kb,memoria_caminhos_kb,memoria_construcao_kb,memoria_2opt_kb";
+    for (int c = 0; c < NUM_CATEGORIAS_MEMORIA; ++c) csv << ",bytes_" << nomeCategoriaMemoria(c);
+    csv << ",custo,rotas,detalhe" << endl;
+    const string colunasVazias(11 + NUM_CATEGORIAS_MEMORIA, ',');
+
+    const ParametrosGerador::Tipo tipos[] = { ParametrosGerador::GRADE, ParametrosGerador::VIARIO };
+    for (int nos : tamanhos) {
+        for (ParametrosGerador::Tipo tipo : tipos) {
+            string nomeTipo = (tipo == ParametrosGerador::GRADE) ? "grade" : "viario";
+            string nome = nomeTipo + "-n" + to_string(nos);
+
+            try {
+                string caminho = instanciaSintetica(pastaSinteticas, tipo, nos);
+                reiniciarPicosCategorias();
+                reiniciarPicoMemoriaResidente();
+                unsigned long long inicioLeitura = __rdtsc();
+                Grafo g(caminho, limiteMemoriaMB * 1024LL * 1024LL);
+                unsigned long long ciclosLeitura = __rdtsc() - inicioLeitura;
+                long long memoriaLeitura = picoMemoriaResidenteKB();
+
+                Solucao solucao = g.resolver();
+                cout << nome << " (" << g.nomeRepresentacao() << "): " << solucao.ciclos << " ciclos, custo " << solucao.custo_total << endl;
+                csv << nomeTipo << "," << nos << "," << g.numeroServicos() << ",ok," << g.nomeRepresentacao() << ","
+                    << ciclosLeitura << "," << solucao.ciclos_caminhos << "," << solucao.ciclos_construcao << "," << solucao.ciclos_2opt << ","
+                    << memoriaLeitura << "," << solucao.memoria_caminhos_kb << "," << solucao.memoria_construcao_kb << "," << solucao.memoria_2opt_kb;
+                for (int c = 0; c < NUM_CATEGORIAS_MEMORIA; ++c) csv << "," << picoBytesPorCategoria()[c].load();
+                csv << "," << solucao.custo_total << "," << solucao.rotas.size() << "," << endl;
+            } catch (const bad_alloc&) {
+                cerr << "ERRO: memoria esgotada ao processar " << nome << endl;
+                csv << nomeTipo << "," << nos << ",,sem_memoria" << colunasVazias << ",memoria esgotada" << endl;
+            } catch (const std::exception& e) {
+                // Só a falta de memória para a representação mais económica conta como sem_memoria; erros de
+                // leitura, escrita ou formato ficam registados como erro, com a mensagem.
+                const string mensagem = e.what();
+                const bool semMemoria = mensagem.compare(0, 30, "Limite de memoria insuficiente") == 0;
+                cerr << "ERRO ao processar instancia " << nome << ": " << mensagem << endl;
+                csv << nomeTipo << "," << nos << ",," << (semMemoria ? "sem_memoria" : "erro") << colunasVazias << ","
+                    << campoCSV(mensagem) << endl;
+            }
+        }
+    }
+    csv.close();
+    cout << "Resultados em: " << caminhoSaida << endl;
+    return 0;
+}
+
+// Compara, nas instâncias sintéticas, a resolução monolítica com a decomposição em grupos (o número de grupos
+// por omissão do Grafo) usando 1, 2, 4, ... threads até ao número de núcleos. A resolução monolítica de referência
+// corre numa só thread (incluindo o 2-opt), pelo que a aceleração em tempo real (ciclos do contador do processador)
+// mede o ganho da decomposição e das suas threads face a essa resolução sequencial. Regista também a penalidade
+// de custo da decomposição face à solução monolítica.
+int executarBenchmarkDecomposicao(long long limiteMemoriaMB, const vector<int>& tamanhos) {
+    string pastaSinteticas = "output/instancias_sinteticas";
+    string caminhoSaida = "output/benchmark_decomposicao.csv";
+
+    #ifdef _WIN32
+        _mkdir(pastaSinteticas.c_str());
+    #else
+        mkdir(pastaSinteticas.c_str(), 0777);
+    #endif
+
+    ofstream csv(caminhoSaida);
+    if (!csv.is_open()) {
+        cerr << "ERRO: Nao foi possivel criar '" << caminhoSaida << "'." << endl;
+        return 1;
+    }
+    csv << "tipo,nos,servicos,representacao,grupos,threads_monolitico,threads,ciclos_monolitico,ciclos_decomposto,aceleracao,"
+        << "custo_monolitico,custo_decomposto,penalidade_custo_pct" << endl;
+
+    const int nucleos = max(1u, thread::hardware_concurrency());
+    const ParametrosGerador::Tipo tipos[] = { ParametrosGerador::GRADE, ParametrosGerador::VIARIO };
+    for (int nos : tamanhos) {
+        for (ParametrosGerador::Tipo tipo : tipos) {
+            string nomeTipo = (tipo == ParametrosGerador::GRADE) ? "grade" : "viario";
+            string caminho = instanciaSintetica(pastaSinteticas, tipo, nos);
+            try {
+                Grafo g(caminho, limiteMemoriaMB * 1024LL * 1024LL);
+                g.calcularCaminhosMinimosComCustos();
+                const int threadsMonolitico = 1;
+                Solucao monolitica = g.resolverComOrcamento(0, threadsMonolitico);
+                unsigned long long ciclosMonolitico = monolitica.ciclos_construcao + monolitica.ciclos_2opt;
+                const int grupos = g.numeroGruposDecomposicao();
+
+                for (int threads = 1; ; threads = min(2 * threads, nucleos)) {
+                    Solucao decomposta = g.resolverDecomposto(grupos, threads);
+                    unsigned long long ciclosDecomposto = decomposta.ciclos_construcao + decomposta.ciclos_2opt;
+                    double penalidade = monolitica.custo_total > 0
+                        ? 100.0 * (decomposta.custo_total - monolitica.custo_total) / monolitica.custo_total : 0.0;
+                    cout << nomeTipo << "-n" << nos << " (" << grupos << " grupos, " << threads << " threads): aceleracao "
+                         << static_cast<double>(ciclosMonolitico) / max(1ULL, ciclosDecomposto) << ", penalidade " << penalidade << "%" << endl;
+                    csv << nomeTipo << "," << nos << "," << g.numeroServicos() << "," << g.nomeRepresentacao() << ","
+                        << grupos << "," << threadsMonolitico << "," << threads << "," << ciclosMonolitico << "," << ciclosDecomposto << ","
+                        << static_cast<double>(ciclosMonolitico) / max(1ULL, ciclosDecomposto) << ","
+                        << monolitica.custo_total << "," << decomposta.custo_total << "," << penalidade << endl;
+                    if (threads >= nucleos) break;
+                }
+            } catch (const std::exception& e) {
+                cerr << "ERRO ao processar instancia " << nomeTipo << "-n" << nos << ": " << e.what() << endl;
+            }
+        }
+    }
+    csv.close();
+    cout << "Resultados em: " << caminhoSaida << endl;
+    return 0;
+}
+
+// Uso: benchmark [tempo [n]] | benchmark escala [limite_memoria_MB [tamanhos...]]
+//      | benchmark decomposicao [limite_memoria_MB [tamanhos...]]
+int main(int argc, char* argv[]) {
+    #ifdef _WIN32
+        _mkdir("output");
+    #else
+        mkdir("output", 0777);
+    #endif
+
+    string modo = (argc > 1) ? argv[1] : "tempo";
+    if (modo == "escala") {
+        long long limiteMemoriaMB = (argc > 2) ? atoll(argv[2]) : 1024;
+        vector<int> tamanhos;
+        for (int i = 3; i < argc; ++i) tamanhos.push_back(atoi(argv[i]));
+        if (tamanhos.empty()) tamanhos = { 1000, 2000, 5000, 10000, 100000, 1000000 };
+        return executarBenchmarkEscala(limiteMemoriaMB, tamanhos);
+    }
+    if (modo == "decomposicao") {
+        long long limiteMemoriaMB = (argc > 2) ? atoll(argv[2]) : 1024;
+        vector<int> tamanhos;
+        for (int i = 3; i < argc; ++i) tamanhos.push_back(atoi(argv[i]));
+        if (tamanhos.empty()) tamanhos = { 10000, 20000, 100000 };
+        return executarBenchmarkDecomposicao(limiteMemoriaMB, tamanhos);
+    }
+    if (modo == "tempo") {
+        size_t limiteInstancias = (argc > 2) ? static_cast<size_t>(atoi(argv[2])) : 0; // 0 processa todas.
+        return executarBenchmarkTempo(limiteInstancias);
+    }
+    cerr << "Uso: " << argv[0] << " [tempo [n]] | escala [limite_memoria_MB [tamanhos...]] | decomposicao [limite_memoria_MB [tamanhos...]]" << endl;
+    return 1;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "GeradorInstancias.h"
+
+using namespace std;
+
+// Mostra a forma de uso do gerador.
+void mostrarUso(const char* programa) {
+    cerr << "Uso: " << programa << " <grade|viario> <numero_de_nos> <arquivo_saida.dat> [opcoes]" << endl;
+    cerr << "Opcoes:" << endl;
+    cerr << "  --nos-req <f>       fracao de nos requeridos (padrao 0.1)" << endl;
+    cerr << "  --arestas-req <f>   fracao de arestas requeridas (padrao 0.3)" << endl;
+    cerr << "  --arcos <f>         fracao de ligacoes de sentido unico (padrao 0.2)" << endl;
+    cerr << "  --arcos-req <f>     fracao de arcos requeridos (padrao 0.3)" << endl;
+    cerr << "  --capacidade <c>    capacidade do veiculo (padrao: ~20 servicos por rota)" << endl;
+    cerr << "  --semente <s>       semente do gerador aleatorio (padrao 42)" << endl;
+}
+
+// Gera uma instância sintética no formato dos ficheiros de dados/MCGRP.
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        mostrarUso(argv[0]);
+        return 1;
+    }
+
+    ParametrosGerador parametros;
+    string tipo = argv[1];
+    if (tipo == "grade") parametros.tipo = ParametrosGerador::GRADE;
+    else if (tipo == "viario") parametros.tipo = ParametrosGerador::VIARIO;
+    else {
+        mostrarUso(argv[0]);
+        return 1;
+    }
+    parametros.numNos = atoi(argv[2]);
+    string caminhoSaida = argv[3];
+
+    for (int i = 4; i < argc; i += 2) {
+        string opcao = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Falta o valor da opcao " << opcao << endl;
+            mostrarUso(argv[0]);
+            return 1;
+        }
+        double valor = atof(argv[i + 1]);
+        if (opcao == "--nos-req") parametros.fracaoNosRequeridos = valor;
+        else if (opcao == "--arestas-req") parametros.fracaoArestasRequeridas = valor;
+        else if (opcao == "--arcos") parametros.fracaoArcos = valor;
+        else if (opcao == "--arcos-req") parametros.fracaoArcosRequeridos = valor;
+        else if (opcao == "--capacidade") parametros.capacidade = static_cast<int>(valor);
+        else if (opcao == "--semente") parametros.semente = static_cast<unsigned int>(valor);
+        else {
+            cerr << "Opcao desconhecida: " << opcao << endl;
+            mostrarUso(argv[0]);
+            return 1;
+        }
+    }
+
+    // O nome da instância é o nome do ficheiro sem diretório nem extensão.
+    string nomeInstancia = caminhoSaida.substr(caminhoSaida.find_last_of("/\\") + 1);
+    nomeInstancia = nomeInstancia.substr(0, nomeInstancia.find_last_of('.'));
+
+    try {
+        gerarInstancia(parametros, nomeInstancia, caminhoSaida);
+    } catch (const std::exception& e) {
+        cerr << "ERRO: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Instancia gerada em: " << caminhoSaida << endl;
+    return 0;
+}
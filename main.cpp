@@ -3,6 +3,7 @@
 #include <sstream>
 #include <vector>
 #include <string>
+#include <cstdlib>
 #include "Grafo.h"
 
 #ifdef _WIN32
@@ -13,36 +14,25 @@
 
 using namespace std;
 
-// Lê os nomes base das instâncias a partir de um arquivo CSV de referência.
-vector<string> lerNomesBaseInstanciasDoCSV(const string& caminhoCSV) {
-    vector<string> nomes;
-    ifstream csvFile(caminhoCSV);
-    string linha;
-
-    if (!csvFile.is_open()) {
-        cerr << "ERRO: Nao foi possivel abrir '" << caminhoCSV << "' para ler nomes de instancias." << endl;
-        return nomes;
-    }
-
-    getline(csvFile, linha); // Ignora a linha de cabeçalho
-
-    while (getline(csvFile, linha)) {
-        stringstream ss(linha);
-        string nomeInstanciaBase;
-        getline(ss, nomeInstanciaBase, ',');
-        if (!nomeInstanciaBase.empty()) {
-            nomes.push_back(limparEspacosGlobal(nomeInstanciaBase));
+// Função principal. Aceita, opcionalmente, um limite de memória em MB para cada instância e
+// `--rotas-expandidas texto|binario` para gravar também os percursos completos das rotas.
+int main(int argc, char* argv[]) {
+    long long limiteMemoriaBytes = 0;
+    FormatoRotasExpandidas formatoRotasExpandidas = ROTAS_EXPANDIDAS_NENHUMA;
+    for (int i = 1; i < argc; ++i) {
+        string argumento = argv[i];
+        if (argumento == "--rotas-expandidas" && i + 1 < argc) {
+            string formato = argv[++i];
+            if (formato == "texto") formatoRotasExpandidas = ROTAS_EXPANDIDAS_TEXTO;
+            else if (formato == "binario") formatoRotasExpandidas = ROTAS_EXPANDIDAS_BINARIO;
+            else {
+                cerr << "Formato de rotas expandidas desconhecido: " << formato << " (use texto ou binario)." << endl;
+                return 1;
+            }
+        } else {
+            limiteMemoriaBytes = atoll(argv[i]) * 1024LL * 1024LL;
         }
     }
-    csvFile.close();
-    if (nomes.empty()) {
-        cerr << "AVISO: Nenhum nome de instancia lido de '" << caminhoCSV << "'" << endl;
-    }
-    return nomes;
-}
-
-// Função principal.
-int main() {
 
     // Bloco para processar uma única instância.
     /*
@@ -114,12 +104,11 @@ int main() {
         checkFile.close();
 
         try {
-            Grafo g_multi(arquivoInstanciaCompleto);
-            
-            // Calcula os caminhos mínimos, essencial para a heurística.
-            g_multi.calcularCaminhosMinimosComCustos();
+            Grafo g_multi(arquivoInstanciaCompleto, limiteMemoriaBytes);
+            g_multi.definirRotasExpandidas(formatoRotasExpandidas);
             
-            // Constrói e salva a solução para a instância atual.
+            // Constrói e salva a solução para a instância atual. Os caminhos mínimos são calculados dentro da
+            // resolução, para que os ciclos gravados os incluam, como os da coluna de referência.
             g_multi.construirESalvarSolucaoVM(nomeInstanciaAtual, pastaDeSaidaParaTodasSolucoes);
 
         } catch (const std::exception& e) {
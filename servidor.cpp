@@ -0,0 +1,638 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include "Grafo.h"
+
+using namespace std;
+
+// Protocolo: cada mensagem, em ambos os sentidos, é um comprimento de 4 bytes (ordem de rede) seguido de
+// um texto com esse número de bytes. Um cliente pode enviar vários pedidos na mesma ligação; são respondidos pela
+// ordem em que chegaram.
+//
+// Pedidos:
+//   RESOLVER <instancia>            primeira linha; as seguintes são opcionais:
+//   ORCAMENTO_MS <n>                limite de tempo para o 2-opt (0 = sem limite)
+//   DEMANDA <id_servico> <valor>    nova demanda do serviço (ex.: DEMANDA E3 4), válida só neste pedido
+//
+//   ESTATISTICAS                    estado da cache e histogramas de latência em CSV
+//   ENCERRAR                        termina o servidor depois de responder
+//
+// Respostas: "OK" ou "ERRO <mensagem>" na primeira linha. Um RESOLVER bem-sucedido devolve as linhas
+// instancia, cache (quente/fria), custo, rotas, penalidade_tempo e latencia_us, seguidas das rotas no
+// formato dos ficheiros de solução.
+const uint32_t TAMANHO_MAXIMO_MENSAGEM = 64u * 1024u * 1024u;
+const int TEMPO_LIMITE_ESCRITA_MS = 10000; // Um cliente que não lê a resposta durante este tempo perde a ligação.
+
+// Escreve exatamente `n` bytes, repetindo após escritas parciais. Num descritor não bloqueante, espera que o
+// cliente liberte espaço, até TEMPO_LIMITE_ESCRITA_MS.
+static bool escreverTudo(int fd, const char* dados, size_t n) {
+    while (n > 0) {
+        ssize_t escritos = send(fd, dados, n, MSG_NOSIGNAL);
+        if (escritos < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            pollfd vigiado = {fd, POLLOUT, 0};
+            if (errno != EINTR && poll(&vigiado, 1, TEMPO_LIMITE_ESCRITA_MS) <= 0) return false;
+            continue;
+        }
+        if (escritos <= 0) return false;
+        dados += escritos;
+        n -= escritos;
+    }
+    return true;
+}
+
+// Lê exatamente `n` bytes; devolve false se a ligação fechar antes.
+static bool lerTudo(int fd, char* dados, size_t n) {
+    while (n > 0) {
+        ssize_t lidos = recv(fd, dados, n, 0);
+        if (lidos <= 0) return false;
+        dados += lidos;
+        n -= lidos;
+    }
+    return true;
+}
+
+static bool enviarMensagem(int fd, const string& texto) {
+    uint32_t tamanho = htonl(static_cast<uint32_t>(texto.size()));
+    return escreverTudo(fd, reinterpret_cast<const char*>(&tamanho), sizeof(tamanho)) && escreverTudo(fd, texto.data(), texto.size());
+}
+
+static bool receberMensagem(int fd, string& texto) {
+    uint32_t tamanho = 0;
+    if (!lerTudo(fd, reinterpret_cast<char*>(&tamanho), sizeof(tamanho))) return false;
+    tamanho = ntohl(tamanho);
+    if (tamanho > TAMANHO_MAXIMO_MENSAGEM) return false;
+    texto.assign(tamanho, '\0');
+    return tamanho == 0 || lerTudo(fd, &texto[0], tamanho);
+}
+
+// Endereço Unix para o caminho indicado; lança exceção se o caminho não couber em sun_path.
+static sockaddr_un enderecoSocket(const string& caminho) {
+    sockaddr_un endereco;
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    if (caminho.size() >= sizeof(endereco.sun_path)) {
+        throw runtime_error("Caminho do socket demasiado longo: " + caminho);
+    }
+    strcpy(endereco.sun_path, caminho.c_str());
+    return endereco;
+}
+
+// Histograma de latências com baldes em potências de 2: o balde k conta os pedidos com latência abaixo de 2^k us.
+class HistogramaLatencia {
+public:
+    static const int NUM_BALDES = 32;
+
+    HistogramaLatencia() : pedidos(0), somaMicrossegundos(0) {
+        for (int k = 0; k < NUM_BALDES; ++k) baldes[k] = 0;
+    }
+
+    void registar(long long microssegundos) {
+        int k = 0;
+        while (k < NUM_BALDES - 1 && (1LL << k) <= microssegundos) k++;
+        baldes[k]++;
+        pedidos++;
+        somaMicrossegundos += microssegundos;
+    }
+
+    unsigned long long totalPedidos() const { return pedidos; }
+
+    double mediaMicrossegundos() const {
+        return pedidos > 0 ? static_cast<double>(somaMicrossegundos) / pedidos : 0.0;
+    }
+
+    // Uma linha CSV por balde não vazio: tipo,limite_superior_us,pedidos.
+    void escreverCSV(ostream& saida, const string& tipo) const {
+        for (int k = 0; k < NUM_BALDES; ++k) {
+            unsigned long long n = baldes[k];
+            if (n > 0) saida << tipo << "," << (1LL << k) << "," << n << "\n";
+        }
+    }
+
+private:
+    atomic<unsigned long long> baldes[NUM_BALDES];
+    atomic<unsigned long long> pedidos;
+    atomic<unsigned long long> somaMicrossegundos;
+};
+
+// Grafo carregado, com as distâncias já calculadas. O trinco serializa os pedidos sobre a mesma instância,
+// porque as alterações de demanda são aplicadas ao grafo durante a resolução e repostas no fim.
+struct EntradaCache {
+    mutex trinco;
+    unique_ptr<Grafo> grafo;
+    long long bytes = 0;
+    bool contada = false; // Protegido pelo trinco do mapa: os bytes já foram somados à ocupação da cache.
+};
+
+// Cache LRU de grafos, limitada pela soma de Grafo::memoriaEstimadaBytes(). Uma entrada retirada da cache
+// continua viva até terminarem os pedidos que ainda a usam.
+class CacheGrafos {
+public:
+    CacheGrafos(const string& pastaInstancias, long long orcamentoBytes, long long limiteMemoriaGrafo)
+        : pasta(pastaInstancias), orcamento(orcamentoBytes), limiteGrafo(limiteMemoriaGrafo), bytesEmUso(0) {}
+
+    // Devolve a entrada da instância com o seu trinco adquirido em `trinco`, carregando-a se ainda não estiver
+    // em memória. `quente` indica se o grafo já estava carregado.
+    shared_ptr<EntradaCache> obter(const string& instancia, unique_lock<mutex>& trinco, bool& quente) {
+        if (instancia.empty() || instancia.find('/') != string::npos || instancia.find('\\') != string::npos) {
+            throw invalid_argument("Nome de instancia invalido: '" + instancia + "'.");
+        }
+
+        shared_ptr<EntradaCache> entrada;
+        {
+            lock_guard<mutex> trincoMapa(trincoEntradas);
+            auto it = entradas.find(instancia);
+            if (it != entradas.end()) {
+                entrada = it->second.first;
+                ordem.splice(ordem.begin(), ordem, it->second.second);
+            } else {
+                entrada = make_shared<EntradaCache>();
+                ordem.push_front(instancia);
+                entradas[instancia] = make_pair(entrada, ordem.begin());
+            }
+        }
+
+        trinco = unique_lock<mutex>(entrada->trinco);
+        quente = entrada->grafo != nullptr;
+        if (quente) return entrada;
+
+        // Carga fria: leitura da instância e caminhos mínimos, fora do trinco do mapa para não bloquear as restantes.
+        try {
+            unique_ptr<Grafo> grafo(new Grafo(pasta + instancia + ".dat", limiteGrafo));
+            grafo->calcularCaminhosMinimosComCustos();
+            entrada->bytes = grafo->memoriaEstimadaBytes();
+            entrada->grafo = move(grafo);
+        } catch (...) {
+            lock_guard<mutex> trincoMapa(trincoEntradas);
+            retirar(instancia, entrada);
+            throw;
+        }
+
+        lock_guard<mutex> trincoMapa(trincoEntradas);
+        auto it = entradas.find(instancia);
+        if (it == entradas.end() || it->second.first != entrada) return entrada; // Retirada durante a carga.
+        entrada->contada = true;
+        bytesEmUso += entrada->bytes;
+        // Retira as entradas menos usadas recentemente até caber no orçamento; a entrada acabada de carregar fica.
+        while (bytesEmUso > orcamento) {
+            auto vitima = prev(ordem.end());
+            if (*vitima == instancia) {
+                if (vitima == ordem.begin()) break;
+                --vitima;
+            }
+            string antiga = *vitima;
+            retirar(antiga, entradas[antiga].first);
+        }
+        return entrada;
+    }
+
+    void escreverResumo(ostream& saida) {
+        lock_guard<mutex> trincoMapa(trincoEntradas);
+        saida << "instancias_em_cache " << entradas.size() << "\n"
+              << "bytes_em_cache " << bytesEmUso << "\n"
+              << "orcamento_bytes " << orcamento << "\n";
+    }
+
+private:
+    // Retira a instância do mapa se ainda corresponder à entrada indicada. Requer trincoEntradas.
+    void retirar(const string& instancia, const shared_ptr<EntradaCache>& entrada) {
+        auto it = entradas.find(instancia);
+        if (it == entradas.end() || it->second.first != entrada) return;
+        if (entrada->contada) bytesEmUso -= entrada->bytes;
+        entrada->contada = false;
+        ordem.erase(it->second.second);
+        entradas.erase(it);
+    }
+
+    string pasta;
+    long long orcamento;
+    long long limiteGrafo;
+    mutex trincoEntradas;
+    list<string> ordem; // Da mais recente para a menos recente.
+    unordered_map<string, pair<shared_ptr<EntradaCache>, list<string>::iterator>> entradas;
+    long long bytesEmUso;
+};
+
+// Estado partilhado pelas threads do servidor.
+struct EstadoServidor {
+    CacheGrafos cache;
+    HistogramaLatencia latenciaQuente; // Pedidos servidos com o grafo já em memória.
+    HistogramaLatencia latenciaFria;   // Pedidos que incluíram a leitura e os caminhos mínimos.
+    atomic<unsigned long long> pedidosComErro;
+    atomic<bool> encerrar;
+    int despertarLeitura, despertarEscrita; // Canal (pipe) que acorda o ciclo principal, bloqueado em poll().
+
+    EstadoServidor(const string& pasta, long long orcamentoBytes, long long limiteGrafo)
+        : cache(pasta, orcamentoBytes, limiteGrafo), pedidosComErro(0), encerrar(false), despertarLeitura(-1), despertarEscrita(-1) {}
+
+    void acordar() {
+        char sinal = 0;
+        if (write(despertarEscrita, &sinal, 1) < 0) {
+            // Canal cheio: o ciclo principal já tem um sinal pendente.
+        }
+    }
+
+    void escreverHistogramas(ostream& saida) {
+        saida << "tipo,limite_superior_us,pedidos\n";
+        latenciaQuente.escreverCSV(saida, "quente");
+        latenciaFria.escreverCSV(saida, "fria");
+    }
+};
+
+// Resolve um pedido RESOLVER. As demandas alteradas são repostas antes de libertar o trinco do grafo,
+// mesmo que a resolução falhe.
+static string resolverPedido(EstadoServidor& estado, istringstream& pedido, const string& instancia,
+                             chrono::steady_clock::time_point inicio) {
+    double orcamentoSegundos = 0;
+    vector<pair<string, int>> demandas;
+    string linha;
+    while (getline(pedido, linha)) {
+        istringstream campos(linha);
+        string chave;
+        if (!(campos >> chave)) continue;
+        if (chave == "ORCAMENTO_MS") {
+            long long ms = 0;
+            if (!(campos >> ms) || ms < 0) throw invalid_argument("ORCAMENTO_MS invalido.");
+            orcamentoSegundos = ms / 1000.0;
+        } else if (chave == "DEMANDA") {
+            string id;
+            int valor;
+            if (!(campos >> id >> valor)) throw invalid_argument("DEMANDA exige <id_servico> <valor>.");
+            demandas.push_back(make_pair(id, valor));
+        } else {
+            throw invalid_argument("Campo desconhecido: " + chave);
+        }
+    }
+
+    unique_lock<mutex> trinco;
+    bool quente = false;
+    shared_ptr<EntradaCache> entrada = estado.cache.obter(instancia, trinco, quente);
+    Grafo& grafo = *entrada->grafo;
+    if (grafo.numeroDias() > 1) {
+        throw invalid_argument("Instancias periodicas nao sao suportadas pelo servidor.");
+    }
+
+    vector<pair<int, int>> originais; // (índice do serviço, demanda original)
+    Solucao solucao;
+    try {
+        for (const auto& d : demandas) {
+            int idx = grafo.indiceServico(d.first);
+            if (idx < 0) throw invalid_argument("Servico desconhecido: " + d.first);
+            originais.push_back(make_pair(idx, grafo.demandaServico(idx)));
+            grafo.definirDemanda(idx, d.second);
+        }
+        // O paralelismo do servidor está nas trabalhadoras: cada pedido faz o 2-opt numa só thread, para que
+        // pedidos simultâneos não disputem os núcleos entre si.
+        solucao = grafo.resolverComOrcamento(orcamentoSegundos, 1);
+    } catch (...) {
+        for (size_t i = originais.size(); i-- > 0;) grafo.definirDemanda(originais[i].first, originais[i].second);
+        throw;
+    }
+    for (size_t i = originais.size(); i-- > 0;) grafo.definirDemanda(originais[i].first, originais[i].second);
+
+    ostringstream rotas;
+    grafo.escreverRotas(rotas, solucao);
+    trinco.unlock();
+
+    long long latencia = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - inicio).count();
+    (quente ? estado.latenciaQuente : estado.latenciaFria).registar(latencia);
+
+    ostringstream resposta;
+    resposta << "OK\n"
+             << "instancia " << instancia << "\n"
+             << "cache " << (quente ? "quente" : "fria") << "\n"
+             << "custo " << solucao.custo_total << "\n"
+             << "rotas " << solucao.rotas.size() << "\n"
+             << "penalidade_tempo " << solucao.penalidade_tempo << "\n"
+             << "latencia_us " << latencia << "\n"
+             << rotas.str();
+    return resposta.str();
+}
+
+// Interpreta um pedido e devolve o texto da resposta.
+static string processarPedido(EstadoServidor& estado, const string& texto) {
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+    istringstream pedido(texto);
+    string primeiraLinha, comando, argumento;
+    getline(pedido, primeiraLinha);
+    istringstream campos(primeiraLinha);
+    campos >> comando >> argumento;
+
+    try {
+        if (comando == "RESOLVER") {
+            return resolverPedido(estado, pedido, argumento, inicio);
+        } else if (comando == "ESTATISTICAS") {
+            ostringstream resposta;
+            resposta << "OK\n";
+            estado.cache.escreverResumo(resposta);
+            resposta << "pedidos_quentes " << estado.latenciaQuente.totalPedidos() << "\n"
+                     << "media_quente_us " << estado.latenciaQuente.mediaMicrossegundos() << "\n"
+                     << "pedidos_frios " << estado.latenciaFria.totalPedidos() << "\n"
+                     << "media_fria_us " << estado.latenciaFria.mediaMicrossegundos() << "\n"
+                     << "pedidos_com_erro " << estado.pedidosComErro << "\n";
+            estado.escreverHistogramas(resposta);
+            return resposta.str();
+        } else if (comando == "ENCERRAR") {
+            // O ciclo principal é acordado depois de a resposta ser enviada (ver trabalhador).
+            estado.encerrar = true;
+            return "OK\n";
+        }
+        throw invalid_argument("Comando desconhecido: '" + comando + "'.");
+    } catch (const std::exception& e) {
+        estado.pedidosComErro++;
+        return string("ERRO ") + e.what() + "\n";
+    }
+}
+
+// Pedido completo lido de uma ligação, à espera de uma thread trabalhadora. Um descritor -1 indica o fim do trabalho.
+struct TarefaPedido {
+    int descritor;
+    string texto;
+};
+
+// Fila de pedidos, consumida pelas threads trabalhadoras, e lista das ligações que as trabalhadoras devolvem ao
+// ciclo principal depois de responder (com a indicação de a ligação continuar utilizável).
+class FilaPedidos {
+public:
+    void colocar(TarefaPedido tarefa) {
+        {
+            lock_guard<mutex> trinco(trincoFila);
+            pedidos.push_back(move(tarefa));
+        }
+        condicao.notify_one();
+    }
+
+    TarefaPedido retirar() {
+        unique_lock<mutex> trinco(trincoFila);
+        condicao.wait(trinco, [this] { return !pedidos.empty(); });
+        TarefaPedido tarefa = move(pedidos.front());
+        pedidos.pop_front();
+        return tarefa;
+    }
+
+    void devolver(int descritor, bool aberta) {
+        lock_guard<mutex> trinco(trincoFila);
+        devolvidas.push_back(make_pair(descritor, aberta));
+    }
+
+    void recolherDevolvidas(vector<pair<int, bool>>& destino) {
+        lock_guard<mutex> trinco(trincoFila);
+        destino.swap(devolvidas);
+        devolvidas.clear();
+    }
+
+private:
+    mutex trincoFila;
+    condition_variable condicao;
+    deque<TarefaPedido> pedidos;
+    vector<pair<int, bool>> devolvidas;
+};
+
+// Responde a um pedido de cada vez; a ligação volta ao ciclo principal, que espera pelo pedido seguinte.
+static void trabalhador(EstadoServidor& estado, FilaPedidos& fila) {
+    while (true) {
+        TarefaPedido tarefa = fila.retirar();
+        if (tarefa.descritor < 0) return;
+        bool aberta = enviarMensagem(tarefa.descritor, processarPedido(estado, tarefa.texto));
+        fila.devolver(tarefa.descritor, aberta);
+        estado.acordar();
+    }
+}
+
+// Ligação aberta no ciclo principal: bytes recebidos que ainda não formam um pedido completo e se há um pedido
+// seu nas trabalhadoras (enquanto houver, a ligação não é lida, para que as respostas saiam pela ordem dos pedidos).
+struct EstadoLigacao {
+    string recebido;
+    bool ocupada = false;
+};
+
+// Entrega às trabalhadoras o primeiro pedido completo de `ligacao`, se já tiver chegado.
+// Devolve false se o comprimento anunciado exceder TAMANHO_MAXIMO_MENSAGEM.
+static bool despacharPedido(int descritor, EstadoLigacao& ligacao, FilaPedidos& fila) {
+    if (ligacao.recebido.size() < sizeof(uint32_t)) return true;
+    uint32_t tamanho = 0;
+    memcpy(&tamanho, ligacao.recebido.data(), sizeof(tamanho));
+    tamanho = ntohl(tamanho);
+    if (tamanho > TAMANHO_MAXIMO_MENSAGEM) return false;
+    if (ligacao.recebido.size() - sizeof(tamanho) < tamanho) return true;
+    fila.colocar({descritor, ligacao.recebido.substr(sizeof(tamanho), tamanho)});
+    ligacao.recebido.erase(0, sizeof(tamanho) + tamanho);
+    ligacao.ocupada = true;
+    return true;
+}
+
+// Inicia o servidor e só regressa depois de um pedido ENCERRAR.
+// A thread principal vigia com poll() o socket de escuta e todas as ligações sem pedido em curso, e só entrega às
+// trabalhadoras pedidos completos: clientes ligados mas inativos não ocupam nenhuma thread.
+static int iniciarServidor(const string& caminhoSocket, int numTrabalhadores, long long orcamentoBytes,
+                           long long limiteGrafo, const string& pastaInstancias) {
+    EstadoServidor estado(pastaInstancias, orcamentoBytes, limiteGrafo);
+    sockaddr_un endereco = enderecoSocket(caminhoSocket);
+
+    int despertar[2];
+    if (pipe(despertar) < 0) {
+        cerr << "ERRO: Nao foi possivel criar o canal interno: " << strerror(errno) << endl;
+        return 1;
+    }
+    estado.despertarLeitura = despertar[0];
+    estado.despertarEscrita = despertar[1];
+    fcntl(despertar[0], F_SETFL, O_NONBLOCK);
+    fcntl(despertar[1], F_SETFL, O_NONBLOCK);
+
+    int descritorEscuta = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descritorEscuta < 0) {
+        cerr << "ERRO: Nao foi possivel criar o socket: " << strerror(errno) << endl;
+        return 1;
+    }
+    unlink(caminhoSocket.c_str()); // Remove um socket deixado por uma execução anterior.
+    if (bind(descritorEscuta, reinterpret_cast<sockaddr*>(&endereco), sizeof(endereco)) < 0 ||
+        listen(descritorEscuta, 64) < 0) {
+        cerr << "ERRO: Nao foi possivel escutar em '" << caminhoSocket << "': " << strerror(errno) << endl;
+        close(descritorEscuta);
+        return 1;
+    }
+
+    FilaPedidos fila;
+    vector<thread> trabalhadores;
+    for (int t = 0; t < numTrabalhadores; ++t) {
+        trabalhadores.push_back(thread(trabalhador, ref(estado), ref(fila)));
+    }
+    cout << "Servidor a escutar em " << caminhoSocket << " com " << numTrabalhadores << " trabalhadores e "
+         << orcamentoBytes / (1024 * 1024) << " MB de cache." << endl;
+
+    unordered_map<int, EstadoLigacao> ligacoes;
+    vector<pollfd> vigiados;
+    vector<pair<int, bool>> devolvidas;
+    vector<char> bloco(1 << 16);
+    auto fechar = [&ligacoes](int descritor) {
+        close(descritor);
+        ligacoes.erase(descritor);
+    };
+
+    while (!estado.encerrar) {
+        vigiados.clear();
+        vigiados.push_back({descritorEscuta, POLLIN, 0});
+        vigiados.push_back({estado.despertarLeitura, POLLIN, 0});
+        for (const auto& l : ligacoes) {
+            if (!l.second.ocupada) vigiados.push_back({l.first, POLLIN, 0});
+        }
+        if (poll(vigiados.data(), vigiados.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            cerr << "ERRO: poll falhou: " << strerror(errno) << endl;
+            break;
+        }
+
+        // Ligações respondidas: voltam a ser lidas, começando pelos pedidos que o cliente já tenha enviado.
+        if (vigiados[1].revents != 0) {
+            while (read(estado.despertarLeitura, bloco.data(), bloco.size()) > 0) {}
+            fila.recolherDevolvidas(devolvidas);
+            for (const auto& d : devolvidas) {
+                auto it = ligacoes.find(d.first);
+                if (it == ligacoes.end()) continue;
+                it->second.ocupada = false;
+                if (!d.second || !despacharPedido(d.first, it->second, fila)) fechar(d.first);
+            }
+        }
+
+        for (size_t i = 2; i < vigiados.size(); ++i) {
+            if (vigiados[i].revents == 0) continue;
+            int descritor = vigiados[i].fd;
+            ssize_t lidos = read(descritor, bloco.data(), bloco.size());
+            if (lidos < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) continue;
+            if (lidos <= 0) {
+                fechar(descritor);
+                continue;
+            }
+            EstadoLigacao& ligacao = ligacoes[descritor];
+            ligacao.recebido.append(bloco.data(), lidos);
+            if (!despacharPedido(descritor, ligacao, fila)) fechar(descritor);
+        }
+
+        if (vigiados[0].revents & POLLIN) {
+            int ligacao = accept(descritorEscuta, nullptr, nullptr);
+            if (ligacao >= 0) {
+                fcntl(ligacao, F_SETFL, O_NONBLOCK);
+                ligacoes[ligacao];
+            } else if (errno != EINTR && errno != EAGAIN && errno != ECONNABORTED) {
+                cerr << "ERRO: accept falhou: " << strerror(errno) << endl;
+                break;
+            }
+        }
+    }
+
+    // Os pedidos já entregues às trabalhadoras são respondidos antes de as threads terminarem. As ligações que os
+    // clientes ainda mantêm abertas são fechadas em seguida, para que o encerramento não fique à espera delas.
+    close(descritorEscuta);
+    unlink(caminhoSocket.c_str());
+    for (int t = 0; t < numTrabalhadores; ++t) fila.colocar({-1, string()});
+    for (thread& t : trabalhadores) t.join();
+    for (const auto& l : ligacoes) {
+        shutdown(l.first, SHUT_RDWR);
+        close(l.first);
+    }
+    close(despertar[0]);
+    close(despertar[1]);
+
+    mkdir("output", 0777);
+    ofstream csv("output/servidor_latencias.csv");
+    if (csv.is_open()) {
+        estado.escreverHistogramas(csv);
+        cout << "Histogramas de latencia gravados em output/servidor_latencias.csv" << endl;
+    }
+    return 0;
+}
+
+// Cliente de linha de comando: envia um pedido e escreve a resposta.
+static int enviarPedido(const string& caminhoSocket, const string& pedido) {
+    sockaddr_un endereco = enderecoSocket(caminhoSocket);
+    int descritor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descritor < 0 || connect(descritor, reinterpret_cast<sockaddr*>(&endereco), sizeof(endereco)) < 0) {
+        cerr << "ERRO: Nao foi possivel ligar a '" << caminhoSocket << "': " << strerror(errno) << endl;
+        if (descritor >= 0) close(descritor);
+        return 1;
+    }
+    string resposta;
+    bool sucesso = enviarMensagem(descritor, pedido) && receberMensagem(descritor, resposta);
+    close(descritor);
+    if (!sucesso) {
+        cerr << "ERRO: Ligacao interrompida pelo servidor." << endl;
+        return 1;
+    }
+    cout << resposta;
+    return resposta.compare(0, 2, "OK") == 0 ? 0 : 2;
+}
+
+static void mostrarUso() {
+    cerr << "Uso:\n"
+         << "  servidor iniciar <socket> [--trabalhadores n] [--cache-mb m] [--limite-grafo-mb l] [--dados pasta]\n"
+         << "  servidor resolver <socket> <instancia> [--orcamento-ms n] [--demanda id=valor ...]\n"
+         << "  servidor estatisticas <socket>\n"
+         << "  servidor encerrar <socket>" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        mostrarUso();
+        return 1;
+    }
+    string modo = argv[1];
+    string caminhoSocket = argv[2];
+
+    try {
+        if (modo == "iniciar") {
+            int numTrabalhadores = max(2u, thread::hardware_concurrency());
+            long long cacheMB = 1024, limiteGrafoMB = 0;
+            string pasta = "dados/MCGRP/";
+            for (int i = 3; i + 1 < argc; i += 2) {
+                string opcao = argv[i];
+                if (opcao == "--trabalhadores") numTrabalhadores = max(1, atoi(argv[i + 1]));
+                else if (opcao == "--cache-mb") cacheMB = atoll(argv[i + 1]);
+                else if (opcao == "--limite-grafo-mb") limiteGrafoMB = atoll(argv[i + 1]);
+                else if (opcao == "--dados") pasta = argv[i + 1];
+                else { mostrarUso(); return 1; }
+            }
+            if (!pasta.empty() && pasta.back() != '/') pasta += '/';
+            return iniciarServidor(caminhoSocket, numTrabalhadores, cacheMB * 1024 * 1024, limiteGrafoMB * 1024 * 1024, pasta);
+        } else if (modo == "resolver" && argc >= 4) {
+            ostringstream pedido;
+            pedido << "RESOLVER " << argv[3] << "\n";
+            for (int i = 4; i + 1 < argc; i += 2) {
+                string opcao = argv[i], valor = argv[i + 1];
+                size_t igual = valor.find('=');
+                if (opcao == "--orcamento-ms") pedido << "ORCAMENTO_MS " << valor << "\n";
+                else if (opcao == "--demanda" && igual != string::npos) pedido << "DEMANDA " << valor.substr(0, igual) << " " << valor.substr(igual + 1) << "\n";
+                else { mostrarUso(); return 1; }
+            }
+            return enviarPedido(caminhoSocket, pedido.str());
+        } else if (modo == "estatisticas") {
+            return enviarPedido(caminhoSocket, "ESTATISTICAS\n");
+        } else if (modo == "encerrar") {
+            return enviarPedido(caminhoSocket, "ENCERRAR\n");
+        }
+    } catch (const std::exception& e) {
+        cerr << "ERRO: " << e.what() << endl;
+        return 1;
+    }
+    mostrarUso();
+    return 1;
+}
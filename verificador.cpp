@@ -0,0 +1,361 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "Grafo.h"
+
+using namespace std;
+
+// Verificador de soluções: confere em paralelo os ficheiros sol-<instancia>.dat de uma pasta contra as instâncias
+// listadas em dados/reference_values.csv e grava, por instância, as violações encontradas e a diferença de custo
+// (gap) para o valor de referência e para a solução de exemplo em dados/padrao_solucoes/, quando existe.
+// Termina com código 1 se alguma solução faltar, não puder ser lida ou tiver violações.
+
+// Ficheiro mapeado em memória só para leitura; um ficheiro vazio fica aberto com inicio == fim.
+// Se não abrir, erro() devolve o errno da falha.
+class ArquivoMapeado {
+public:
+    explicit ArquivoMapeado(const string& caminho) : dados(nullptr), tamanho(0), aberto(false), codigoErro(0) {
+        int fd = open(caminho.c_str(), O_RDONLY);
+        if (fd < 0) {
+            codigoErro = errno;
+            return;
+        }
+        struct stat estado;
+        if (fstat(fd, &estado) != 0) {
+            codigoErro = errno;
+        } else {
+            tamanho = estado.st_size;
+            if (tamanho == 0) {
+                aberto = true;
+            } else {
+                void* mapa = mmap(nullptr, tamanho, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapa != MAP_FAILED) {
+                    dados = static_cast<const char*>(mapa);
+                    aberto = true;
+                } else {
+                    codigoErro = errno;
+                }
+            }
+        }
+        close(fd);
+    }
+    ~ArquivoMapeado() {
+        if (dados != nullptr) munmap(const_cast<char*>(dados), tamanho);
+    }
+    ArquivoMapeado(const ArquivoMapeado&) = delete;
+    ArquivoMapeado& operator=(const ArquivoMapeado&) = delete;
+
+    bool estaAberto() const { return aberto; }
+    int erro() const { return codigoErro; }
+    const char* inicio() const { return dados; }
+    const char* fim() const { return dados + tamanho; }
+
+private:
+    const char* dados;
+    size_t tamanho;
+    bool aberto;
+    int codigoErro;
+};
+
+// Leitura sequencial do texto de uma solução, diretamente sobre o ficheiro mapeado.
+class LeitorSolucao {
+public:
+    LeitorSolucao(const char* inicio, const char* fim) : atual(inicio), fim(fim) {}
+
+    size_t restantes() const { return fim - atual; }
+    bool terminou() {
+        saltarEspacos();
+        return atual == fim;
+    }
+    bool inteiro(long long& valor) {
+        saltarEspacos();
+        bool negativo = atual != fim && *atual == '-';
+        if (negativo) ++atual;
+        if (atual == fim || *atual < '0' || *atual > '9') return false;
+        valor = 0;
+        while (atual != fim && *atual >= '0' && *atual <= '9') valor = valor * 10 + (*atual++ - '0');
+        if (negativo) valor = -valor;
+        return true;
+    }
+    // Paragem no formato "(X id,u,v)".
+    bool parada(ParadaRota& parada) {
+        long long u = 0, v = 0;
+        if (!simbolo('(')) return false;
+        saltarEspacos();
+        if (atual == fim) return false;
+        parada.tipo_parada = *atual++;
+        saltarEspacos();
+        const char* inicioId = atual;
+        while (atual != fim && *atual != ',' && *atual != ' ' && *atual != '\t') ++atual;
+        parada.id_servico.assign(inicioId, atual);
+        if (!simbolo(',') || !inteiro(u) || !simbolo(',') || !inteiro(v) || !simbolo(')')) return false;
+        parada.u = u;
+        parada.v = v;
+        parada.idx_servico = -1;
+        return true;
+    }
+
+private:
+    void saltarEspacos() {
+        while (atual != fim && (*atual == ' ' || *atual == '\t' || *atual == '\r' || *atual == '\n')) ++atual;
+    }
+    bool simbolo(char c) {
+        saltarEspacos();
+        if (atual == fim || *atual != c) return false;
+        ++atual;
+        return true;
+    }
+
+    const char* atual;
+    const char* fim;
+};
+
+// Lê as rotas de um ficheiro já mapeado (ver lerSolucao).
+static bool lerRotas(const ArquivoMapeado& arquivo, Solucao& solucao, long long& rotasDeclaradas, string& erro) {
+    LeitorSolucao leitor(arquivo.inicio(), arquivo.fim());
+    long long custoTotal = 0, ciclos = 0, ciclosReferencia = 0;
+    if (!leitor.inteiro(custoTotal) || !leitor.inteiro(rotasDeclaradas) || !leitor.inteiro(ciclos) || !leitor.inteiro(ciclosReferencia)) {
+        erro = "cabecalho incompleto";
+        return false;
+    }
+    solucao.custo_total = custoTotal;
+    solucao.ciclos = ciclos;
+    while (!leitor.terminou()) {
+        long long deposito = 0, dia = 0, id = 0, demanda = 0, custo = 0, numParadas = 0;
+        if (!leitor.inteiro(deposito) || !leitor.inteiro(dia) || !leitor.inteiro(id) || !leitor.inteiro(demanda) ||
+            !leitor.inteiro(custo) || !leitor.inteiro(numParadas) || numParadas < 0) {
+            erro = "rota " + to_string(solucao.rotas.size() + 1) + " mal formada";
+            return false;
+        }
+        // Cada paragem ocupa vários bytes: um número maior do que o resto do ficheiro só pode estar corrompido.
+        if (numParadas > static_cast<long long>(leitor.restantes())) {
+            erro = "rota " + to_string(solucao.rotas.size() + 1) + " declara mais paragens do que cabem no ficheiro";
+            return false;
+        }
+        Rota rota;
+        rota.id_rota = id;
+        rota.dia = dia;
+        rota.demanda_total = demanda;
+        rota.custo_total = custo;
+        rota.paradas.resize(numParadas);
+        for (ParadaRota& parada : rota.paradas) {
+            if (!leitor.parada(parada)) {
+                erro = "paragem mal formada na rota " + to_string(solucao.rotas.size() + 1);
+                return false;
+            }
+        }
+        solucao.rotas.push_back(move(rota));
+    }
+    return true;
+}
+
+// Lê uma solução: custo total, número de rotas e os dois campos de ciclos, seguidos de uma linha por rota
+// (depósito, dia, id, demanda, custo, número de paragens e as paragens). Devolve false com a descrição do erro;
+// `encontrado` indica se o ficheiro existe. Nenhuma falha de leitura ou de memória sai desta função.
+static bool lerSolucao(const string& caminho, Solucao& solucao, long long& rotasDeclaradas, string& erro, bool& encontrado) {
+    ArquivoMapeado arquivo(caminho);
+    encontrado = arquivo.estaAberto() || arquivo.erro() != ENOENT;
+    if (!arquivo.estaAberto()) {
+        erro = encontrado ? string("falha ao abrir: ") + strerror(arquivo.erro()) : "ficheiro nao encontrado";
+        return false;
+    }
+    try {
+        return lerRotas(arquivo, solucao, rotasDeclaradas, erro);
+    } catch (const std::exception& e) {
+        erro = string("falha na leitura: ") + e.what();
+        return false;
+    }
+}
+
+// Valores de referência de uma instância (colunas Nome e Solucao de dados/reference_values.csv).
+struct Referencia {
+    string nome;
+    double custo;
+    long long rotas;
+};
+
+static vector<Referencia> lerReferencias(const string& caminhoCSV) {
+    vector<Referencia> referencias;
+    ifstream csv(caminhoCSV);
+    if (!csv.is_open()) {
+        cerr << "ERRO: Nao foi possivel abrir '" << caminhoCSV << "'." << endl;
+        return referencias;
+    }
+    string linha;
+    getline(csv, linha); // Ignora a linha de cabeçalho
+    while (getline(csv, linha)) {
+        stringstream ss(linha);
+        string nome, custo, rotas;
+        if (!getline(ss, nome, ',') || limparEspacosGlobal(nome).empty()) continue;
+        getline(ss, custo, ',');
+        getline(ss, rotas, ',');
+        referencias.push_back({limparEspacosGlobal(nome), atof(custo.c_str()), atoll(rotas.c_str())});
+    }
+    return referencias;
+}
+
+// Resultado da verificação de uma instância, para uma linha do CSV.
+struct ResultadoInstancia {
+    string estado = "ok"; // ok, violacoes, sem_solucao, erro_leitura ou erro_instancia
+    string detalhe;
+    long long custo = 0;
+    long long rotas = 0;
+    bool rotasConsistentes = true; // O número de rotas do cabeçalho coincide com as linhas de rotas.
+    VerificacaoSolucao verificacao;
+    bool temPadrao = false;
+    long long custoPadrao = 0;
+    int violacoesPadrao = 0;
+};
+
+static ResultadoInstancia verificarInstancia(const Referencia& referencia, const string& pastaSolucoes, const string& pastaDados,
+                                             const string& pastaPadrao) {
+    ResultadoInstancia resultado;
+    Solucao solucao;
+    string erro;
+    bool encontrado = false;
+    if (!lerSolucao(pastaSolucoes + "sol-" + referencia.nome + ".dat", solucao, resultado.rotas, erro, encontrado)) {
+        resultado.estado = encontrado ? "erro_leitura" : "sem_solucao";
+        resultado.detalhe = erro;
+        return resultado;
+    }
+    resultado.custo = solucao.custo_total;
+    resultado.rotasConsistentes = resultado.rotas == static_cast<long long>(solucao.rotas.size());
+
+    try {
+        Grafo grafo(pastaDados + referencia.nome + ".dat");
+        resultado.verificacao = grafo.verificarSolucao(solucao);
+
+        // A solução de exemplo é conferida na sua própria convenção de custo, sem o atendimento.
+        Solucao padrao;
+        long long rotasPadrao = 0;
+        if (lerSolucao(pastaPadrao + "sol-" + referencia.nome + ".dat", padrao, rotasPadrao, erro, encontrado)) {
+            resultado.temPadrao = true;
+            resultado.custoPadrao = padrao.custo_total;
+            resultado.violacoesPadrao = grafo.verificarSolucao(padrao, false).totalViolacoes() +
+                                        (rotasPadrao == static_cast<long long>(padrao.rotas.size()) ? 0 : 1);
+        } else if (encontrado) {
+            resultado.detalhe = "solucao de exemplo ilegivel: " + erro;
+        }
+    } catch (const std::exception& e) {
+        resultado.estado = "erro_instancia";
+        resultado.detalhe = e.what();
+        return resultado;
+    }
+    if (resultado.verificacao.totalViolacoes() > 0 || !resultado.rotasConsistentes) resultado.estado = "violacoes";
+    return resultado;
+}
+
+// Campo de texto do CSV, entre aspas (com as aspas interiores duplicadas) se tiver vírgulas, aspas ou quebras de linha.
+static string campoCSV(const string& texto) {
+    if (texto.find_first_of(",\"\r\n") == string::npos) return texto;
+    string campo = "\"";
+    for (char c : texto) {
+        if (c == '"') campo += '"';
+        campo += c;
+    }
+    return campo + "\"";
+}
+
+// Diferença percentual de `custo` em relação a `referencia`, vazia quando não há referência.
+static string gap(long long custo, double referencia) {
+    if (referencia <= 0) return "";
+    ostringstream texto;
+    texto << fixed << setprecision(2) << 100.0 * (custo - referencia) / referencia;
+    return texto.str();
+}
+
+static void mostrarUso() {
+    cerr << "Uso:\n"
+         << "  verificador [pasta_solucoes] [--threads n] [--dados pasta] [--padrao pasta] [--referencias csv] [--saida csv]\n"
+         << "  (por omissao: output/solucoes_etapa3, dados/MCGRP/, dados/padrao_solucoes/, dados/reference_values.csv,\n"
+         << "   output/verificacao.csv)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string pastaSolucoes = "output/solucoes_etapa3/", pastaDados = "dados/MCGRP/", pastaPadrao = "dados/padrao_solucoes/";
+    string caminhoReferencias = "dados/reference_values.csv", caminhoSaida = "output/verificacao.csv";
+    int numThreads = max(1u, thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        string opcao = argv[i];
+        if (opcao.compare(0, 2, "--") != 0) { pastaSolucoes = opcao; continue; }
+        if (i + 1 >= argc) { mostrarUso(); return 1; }
+        string valor = argv[++i];
+        if (opcao == "--threads") numThreads = max(1, atoi(valor.c_str()));
+        else if (opcao == "--dados") pastaDados = valor;
+        else if (opcao == "--padrao") pastaPadrao = valor;
+        else if (opcao == "--referencias") caminhoReferencias = valor;
+        else if (opcao == "--saida") caminhoSaida = valor;
+        else { mostrarUso(); return 1; }
+    }
+    for (string* pasta : {&pastaSolucoes, &pastaDados, &pastaPadrao}) {
+        if (!pasta->empty() && pasta->back() != '/') *pasta += '/';
+    }
+
+    vector<Referencia> referencias = lerReferencias(caminhoReferencias);
+    if (referencias.empty()) return 1;
+
+    // Cada thread lê e confere uma instância de cada vez; os resultados ficam na posição da instância no CSV.
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+    vector<ResultadoInstancia> resultados(referencias.size());
+    atomic<size_t> proxima(0);
+    auto trabalhar = [&]() {
+        for (size_t i = proxima++; i < referencias.size(); i = proxima++) {
+            resultados[i] = verificarInstancia(referencias[i], pastaSolucoes, pastaDados, pastaPadrao);
+        }
+    };
+    vector<thread> trabalhadores;
+    for (int t = 1; t < min<int>(numThreads, referencias.size()); ++t) trabalhadores.emplace_back(trabalhar);
+    trabalhar();
+    for (thread& t : trabalhadores) t.join();
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    ofstream csv(caminhoSaida);
+    if (!csv.is_open()) {
+        cerr << "ERRO: Nao foi possivel criar '" << caminhoSaida << "'." << endl;
+        return 1;
+    }
+    // Os valores de referência e as soluções de exemplo não incluem o atendimento (S. COST) no custo: os gaps comparam-nos
+    // com custo_sem_atendimento, o custo declarado menos o atendimento das visitas feitas.
+    csv << "instancia,estado,detalhe,custo,custo_recalculado,custo_sem_atendimento,rotas,rotas_consistentes,custo_total_consistente,"
+        << "servicos_em_falta,servicos_repetidos,paragens_invalidas,ligacoes_inalcancaveis,rotas_acima_capacidade,"
+        << "rotas_demanda_divergente,rotas_custo_divergente,dias_invalidos,violacoes,"
+        << "custo_referencia,rotas_referencia,gap_referencia_pct,custo_padrao,violacoes_padrao,gap_padrao_pct\n";
+    int comProblemas = 0;
+    for (size_t i = 0; i < referencias.size(); ++i) {
+        const ResultadoInstancia& r = resultados[i];
+        const VerificacaoSolucao& v = r.verificacao;
+        const bool lida = r.estado == "ok" || r.estado == "violacoes";
+        if (r.estado != "ok") comProblemas++;
+        const long long custoSemAtendimento = r.custo - v.custo_atendimento;
+        csv << campoCSV(referencias[i].nome) << "," << r.estado << "," << campoCSV(r.detalhe) << ",";
+        if (lida) {
+            csv << r.custo << "," << v.custo_recalculado << "," << custoSemAtendimento << "," << r.rotas << "," << r.rotasConsistentes << "," << v.custo_total_consistente << ","
+                << v.servicos_em_falta << "," << v.servicos_repetidos << "," << v.paragens_invalidas << "," << v.ligacoes_inalcancaveis << ","
+                << v.rotas_acima_capacidade << "," << v.rotas_demanda_divergente << "," << v.rotas_custo_divergente << "," << v.dias_invalidos << ","
+                << v.totalViolacoes() + (r.rotasConsistentes ? 0 : 1) << ",";
+        } else {
+            csv << ",,,,,,,,,,,,,,,";
+        }
+        csv << referencias[i].custo << "," << referencias[i].rotas << "," << (lida ? gap(custoSemAtendimento, referencias[i].custo) : "") << ",";
+        if (lida && r.temPadrao) csv << r.custoPadrao << "," << r.violacoesPadrao << "," << gap(custoSemAtendimento, r.custoPadrao);
+        else csv << ",,";
+        csv << "\n";
+    }
+
+    cout << referencias.size() << " instancias verificadas em " << fixed << setprecision(3) << segundos << " s com " << numThreads
+         << " thread(s); " << comProblemas << " com problemas. Resultados em " << caminhoSaida << endl;
+    return comProblemas > 0 ? 1 : 0;
+}